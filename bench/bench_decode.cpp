@@ -0,0 +1,241 @@
+// Compares the table driven NinjiFrameDecoder against the per frame checked decoder it replaced, on inflated replays
+// from a database such as one made by gen_ninji_db
+// Usage: bench_decode <db> [max replays] [rounds] [chunk size]
+
+#include "replay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+// Previous implementation, kept verbatim as the baseline
+static size_t legacy_ninji_frame_size(const uint8_t* frame, size_t available) {
+	uint8_t flags = frame[0] >> 4;
+	if(!(flags & 0b00000110)) {
+		return 5;
+	}
+
+	if(available < 6) {
+		return 0;
+	}
+
+	uint8_t unk1 = frame[5];
+	if(unk1 & 0b00000110) {
+		// TODO
+		return 6;
+	} else if(unk1 & 0b00011000) {
+		return 8;
+	}
+
+	// MISSING LOGIC
+	return 6;
+}
+
+static NinjiFrame legacy_read_ninji_frame(const uint8_t* frame) {
+	uint8_t flags        = frame[0] >> 4;
+	uint8_t player_state = frame[0] & 0x0F;
+	uint16_t x;
+	uint16_t y;
+	memcpy(&x, &frame[1], sizeof(x));
+	memcpy(&y, &frame[3], sizeof(y));
+	return NinjiFrame { player_state, x, y, flags };
+}
+
+class LegacyNinjiFrameDecoder {
+public:
+	bool feed(std::span<const uint8_t> data, std::vector<NinjiFrame>& frames) {
+		size_t pos = 0;
+
+		if(header_size < NINJI_HEADER_SIZE) {
+			size_t needed = std::min(NINJI_HEADER_SIZE - header_size, data.size());
+			memcpy(&header[header_size], data.data(), needed);
+			header_size += needed;
+			pos += needed;
+
+			if(header_size < NINJI_HEADER_SIZE) {
+				return true;
+			}
+
+			uint32_t num_frames;
+			memcpy(&num_frames, &header[0x10], sizeof(num_frames));
+			toLittleEndian(num_frames);
+
+			charactor = header[0x14];
+
+			// Ninji's are rendered every 4 frames, 2 is because the frames is always two less than it should be
+			frames_left = (num_frames + 2) / 4;
+			frames.reserve(frames.size() + frames_left);
+		}
+
+		while(frames_left && pos < data.size()) {
+			if(pending_size == 0 && data.size() - pos >= NINJI_MAX_FRAME_SIZE) {
+				// Whole frame is in this chunk
+				frames.push_back(legacy_read_ninji_frame(&data[pos]));
+				pos += legacy_ninji_frame_size(&data[pos], NINJI_MAX_FRAME_SIZE);
+				frames_left--;
+			} else {
+				// Frame straddles the end of the chunk, collect it a byte at a time
+				pending[pending_size++] = data[pos++];
+				size_t size             = legacy_ninji_frame_size(pending, pending_size);
+				if(size && pending_size == size) {
+					frames.push_back(legacy_read_ninji_frame(pending));
+					pending_size = 0;
+					frames_left--;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool finished() const {
+		return header_size == NINJI_HEADER_SIZE && frames_left == 0;
+	}
+
+	uint8_t charactor = 0;
+
+private:
+	uint8_t header[NINJI_HEADER_SIZE];
+	size_t header_size   = 0;
+	uint32_t frames_left = 0;
+	uint8_t pending[NINJI_MAX_FRAME_SIZE];
+	size_t pending_size = 0;
+};
+
+// Field by field, the padding of NinjiFrame is never written
+static bool same_frame(const NinjiFrame& a, const NinjiFrame& b) {
+	return a.state == b.state && a.x == b.x && a.y == b.y && a.flags == b.flags;
+}
+
+// Feeds replay in chunks of chunk_size, like streaming does, or whole when chunk_size is 0
+template <typename Decoder>
+static bool decode_chunked(Decoder& decoder, std::span<const uint8_t> replay, size_t chunk_size,
+	std::vector<NinjiFrame>& frames) {
+	if(chunk_size == 0) {
+		decoder.feed(replay, frames);
+		return decoder.finished();
+	}
+	for(size_t offset = 0; offset < replay.size() && !decoder.finished(); offset += chunk_size) {
+		if(!decoder.feed(replay.subspan(offset, std::min(chunk_size, replay.size() - offset)), frames)) {
+			break;
+		}
+	}
+	return decoder.finished();
+}
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::cout << "Usage: bench_decode <db> [max replays] [rounds] [chunk size]" << std::endl;
+		return 1;
+	}
+
+	int max_replays   = argc > 2 ? atoi(argv[2]) : 10000;
+	int rounds        = argc > 3 ? atoi(argv[3]) : 5;
+	size_t chunk_size = argc > 4 ? atoi(argv[4]) : 0;
+
+	sqlite3* db;
+	if(sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+		std::cout << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+		return 1;
+	}
+
+	sqlite3_stmt* res;
+	if(sqlite3_prepare_v2(db, "SELECT replay FROM ninji LIMIT ?", -1, &res, 0) != SQLITE_OK) {
+		std::cout << "Sqlite could not prepare query: " << sqlite3_errmsg(db) << std::endl;
+		return 1;
+	}
+	sqlite3_bind_int(res, 1, max_replays);
+
+	// Inflated once up front, only decoding is timed
+	std::vector<std::vector<uint8_t>> replays;
+	size_t inflated_bytes = 0;
+	while(sqlite3_step(res) == SQLITE_ROW) {
+		std::span<const uint8_t> output;
+		if(gzip_decompress((const uint8_t*)sqlite3_column_blob(res, 0), sqlite3_column_bytes(res, 0), output)) {
+			replays.emplace_back(output.begin(), output.end());
+			inflated_bytes += output.size();
+		}
+	}
+	sqlite3_finalize(res);
+	sqlite3_close(db);
+
+	if(replays.empty()) {
+		std::cout << "No replays found" << std::endl;
+		return 1;
+	}
+
+	// Both decoders must agree on every replay the new one accepts, the new one only rejects replays earlier
+	size_t num_frames = 0;
+	uint64_t malformed[NINJI_DECODE_ERROR_COUNT] {};
+	uint64_t guessed = 0;
+	std::vector<NinjiFrame> legacy_frames;
+	std::vector<NinjiFrame> frames;
+	for(auto& replay : replays) {
+		legacy_frames.clear();
+		frames.clear();
+		LegacyNinjiFrameDecoder legacy_decoder;
+		NinjiFrameDecoder decoder(chunk_size ? 0 : replay.size());
+		bool legacy_ok = decode_chunked(legacy_decoder, replay, chunk_size, legacy_frames);
+		bool ok        = decode_chunked(decoder, replay, chunk_size, frames);
+		auto status    = decoder.status();
+		if(ok != legacy_ok
+			|| (ok && !std::equal(frames.begin(), frames.end(), legacy_frames.begin(), legacy_frames.end(), same_frame))) {
+			std::cout << "Decoders differ" << std::endl;
+			return 1;
+		}
+		num_frames += frames.size();
+		malformed[(size_t)status.error]++;
+		guessed += status.guessed_frames != 0;
+	}
+
+	std::cout << replays.size() << " replays, " << inflated_bytes / 1000000.0 << " MB inflated, " << num_frames
+			  << " frames, " << rounds << " rounds, "
+			  << (chunk_size ? std::to_string(chunk_size) + " byte chunks" : std::string("whole replays")) << std::endl;
+	for(size_t i = 1; i < NINJI_DECODE_ERROR_COUNT; i++) {
+		if(malformed[i]) {
+			std::cout << malformed[i] << " replays rejected, " << ninji_decode_error_name((NinjiDecodeError)i)
+					  << std::endl;
+		}
+	}
+	if(guessed) {
+		std::cout << guessed << " replays have frames in an undocumented layout" << std::endl;
+	}
+
+	auto report = [&](const char* name, double seconds) {
+		double frames_decoded = (double)num_frames * rounds;
+		std::cout << name << ": " << frames_decoded / seconds / 1000000.0 << " M frames/s, "
+				  << inflated_bytes * rounds / 1000000.0 / seconds << " MB/s" << std::endl;
+	};
+
+	// Frame vectors are reused like an ingest worker would, so the timing is the decoder and not the allocator
+	auto start = std::chrono::steady_clock::now();
+	for(int round = 0; round < rounds; round++) {
+		for(auto& replay : replays) {
+			legacy_frames.clear();
+			LegacyNinjiFrameDecoder legacy_decoder;
+			decode_chunked(legacy_decoder, replay, chunk_size, legacy_frames);
+		}
+	}
+	double legacy_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report("legacy decoder", legacy_seconds);
+
+	start = std::chrono::steady_clock::now();
+	for(int round = 0; round < rounds; round++) {
+		for(auto& replay : replays) {
+			frames.clear();
+			NinjiFrameDecoder decoder(chunk_size ? 0 : replay.size());
+			decode_chunked(decoder, replay, chunk_size, frames);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report("NinjiFrameDecoder", seconds);
+
+	std::cout << "Speedup: " << legacy_seconds / seconds << "x" << std::endl;
+
+	return 0;
+}
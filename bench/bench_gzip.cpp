@@ -0,0 +1,168 @@
+// Compares gzip_decompress against the calloc and grow implementation it replaced, on real replay blobs
+// Usage: bench_gzip <db> [data_id] [max replays] [rounds]
+
+#include "replay.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+// Previous implementation, kept verbatim as the baseline
+bool legacy_gzip_decompress(uint8_t* input, int input_size, std::vector<uint8_t>& output) {
+	output.clear();
+
+	unsigned full_length = input_size;
+	unsigned half_length = input_size / 2;
+
+	unsigned uncompLength = full_length;
+	char* uncomp          = (char*)calloc(sizeof(char), uncompLength);
+
+	z_stream strm;
+	strm.next_in   = input;
+	strm.avail_in  = input_size;
+	strm.total_out = 0;
+	strm.zalloc    = Z_NULL;
+	strm.zfree     = Z_NULL;
+
+	bool done = false;
+
+	if(inflateInit2(&strm, (32 + MAX_WBITS)) != Z_OK) {
+		free(uncomp);
+		return false;
+	}
+
+	while(!done) {
+		// If our output buffer is too small
+		if(strm.total_out >= uncompLength) {
+			// Increase size of output buffer
+			char* uncomp2 = (char*)calloc(sizeof(char), uncompLength + half_length);
+			memcpy(uncomp2, uncomp, uncompLength);
+			uncompLength += half_length;
+			free(uncomp);
+			uncomp = uncomp2;
+		}
+
+		strm.next_out  = (Bytef*)(uncomp + strm.total_out);
+		strm.avail_out = uncompLength - strm.total_out;
+
+		// Inflate another chunk.
+		int err = inflate(&strm, Z_SYNC_FLUSH);
+		if(err == Z_STREAM_END)
+			done = true;
+		else if(err != Z_OK) {
+			break;
+		}
+	}
+
+	if(inflateEnd(&strm) != Z_OK) {
+		free(uncomp);
+		return false;
+	}
+
+	std::copy(uncomp, uncomp + strm.total_out, std::back_inserter(output));
+
+	free(uncomp);
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::cout << "Usage: bench_gzip <db> [data_id] [max replays] [rounds]" << std::endl;
+		return 1;
+	}
+
+	int data_id     = argc > 2 ? atoi(argv[2]) : 0;
+	int max_replays = argc > 3 ? atoi(argv[3]) : 10000;
+	int rounds      = argc > 4 ? atoi(argv[4]) : 5;
+
+	sqlite3* db;
+	if(sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+		std::cout << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+		return 1;
+	}
+
+	sqlite3_stmt* res;
+	const char* query
+		= data_id ? "SELECT replay FROM ninji WHERE data_id = ? LIMIT ?" : "SELECT replay FROM ninji LIMIT ?";
+	if(sqlite3_prepare_v2(db, query, -1, &res, 0) != SQLITE_OK) {
+		std::cout << "Sqlite could not prepare query: " << sqlite3_errmsg(db) << std::endl;
+		return 1;
+	}
+	if(data_id) {
+		sqlite3_bind_int(res, 1, data_id);
+		sqlite3_bind_int(res, 2, max_replays);
+	} else {
+		sqlite3_bind_int(res, 1, max_replays);
+	}
+
+	std::vector<std::vector<uint8_t>> blobs;
+	size_t compressed_bytes = 0;
+	while(sqlite3_step(res) == SQLITE_ROW) {
+		const uint8_t* blob = (const uint8_t*)sqlite3_column_blob(res, 0);
+		int size            = sqlite3_column_bytes(res, 0);
+		blobs.emplace_back(blob, blob + size);
+		compressed_bytes += size;
+	}
+	sqlite3_finalize(res);
+	sqlite3_close(db);
+
+	if(blobs.empty()) {
+		std::cout << "No replays found" << std::endl;
+		return 1;
+	}
+
+	// Both implementations must agree before timing means anything
+	size_t inflated_bytes = 0;
+	std::vector<uint8_t> legacy_output;
+	for(auto& blob : blobs) {
+		std::span<const uint8_t> output;
+		bool legacy_ok = legacy_gzip_decompress(blob.data(), blob.size(), legacy_output);
+		bool ok        = gzip_decompress(blob.data(), blob.size(), output);
+		if(legacy_ok != ok || legacy_output.size() != output.size()
+			|| memcmp(legacy_output.data(), output.data(), output.size()) != 0) {
+			std::cout << "Outputs differ" << std::endl;
+			return 1;
+		}
+		inflated_bytes += output.size();
+	}
+
+	std::cout << blobs.size() << " replays, " << compressed_bytes / 1000000.0 << " MB compressed, "
+			  << inflated_bytes / 1000000.0 << " MB inflated, " << rounds << " rounds" << std::endl;
+
+	auto report = [&](const char* name, double seconds) {
+		double replays = (double)blobs.size() * rounds;
+		std::cout << name << ": " << seconds * 1e9 / replays << " ns/replay, "
+				  << inflated_bytes * rounds / 1000000.0 / seconds << " MB/s inflated" << std::endl;
+	};
+
+	// The legacy path also pre-sized a vector per replay before clearing it, include that allocation
+	auto start = std::chrono::steady_clock::now();
+	for(int round = 0; round < rounds; round++) {
+		for(auto& blob : blobs) {
+			std::vector<uint8_t> decompressed_replay(blob.size());
+			legacy_gzip_decompress(blob.data(), blob.size(), decompressed_replay);
+		}
+	}
+	double legacy_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report("legacy gzip_decompress", legacy_seconds);
+
+	start = std::chrono::steady_clock::now();
+	for(int round = 0; round < rounds; round++) {
+		for(auto& blob : blobs) {
+			std::span<const uint8_t> output;
+			gzip_decompress(blob.data(), blob.size(), output);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report("gzip_decompress", seconds);
+
+	std::cout << "Speedup: " << legacy_seconds / seconds << "x" << std::endl;
+
+	return 0;
+}
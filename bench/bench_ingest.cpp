@@ -0,0 +1,86 @@
+// Times ingest_replays over every replay in a database, such as one made by gen_ninji_db
+// Usage: bench_ingest <db> [threads] [stream 0/1] [rounds] [shards]
+
+#include "ingest.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::cout << "Usage: bench_ingest <db> [threads] [stream 0/1] [rounds] [shards]" << std::endl;
+		return 1;
+	}
+
+	int threads = argc > 2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+	bool stream = argc > 3 ? atoi(argv[3]) : false;
+	int rounds  = argc > 4 ? atoi(argv[4]) : 3;
+	int shards  = argc > 5 ? atoi(argv[5]) : 1;
+
+	DatabaseOptions database_options;
+	database_options.immutable = true;
+
+	sqlite3* db;
+	if(!open_database(argv[1], database_options, &db)) {
+		return 1;
+	}
+
+	IngestOptions options;
+	options.num_workers    = threads;
+	options.stream_replays = stream;
+	options.db_path        = argv[1];
+	options.database       = database_options;
+	options.num_shards     = shards;
+
+	// The sharded scan appends its rowid range to the WHERE clause
+	std::string query = std::string("SELECT data_id,pid,time,") + (stream ? "rowid" : "replay") + " FROM ninji WHERE 1";
+	auto on_replay    = [](IngestedReplay&) { return true; };
+
+	IngestStats total;
+	for(int round = 0; round < rounds; round++) {
+		IngestStats stats;
+		bool ok;
+		if(shards > 1) {
+			ok = ingest_replays_sharded(db, query, {}, options, on_replay, stats);
+		} else {
+			sqlite3_stmt* res;
+			if(sqlite3_prepare_v2(db, query.c_str(), -1, &res, 0) != SQLITE_OK) {
+				std::cout << "Sqlite could not prepare query: " << sqlite3_errmsg(db) << std::endl;
+				return 1;
+			}
+			ok = ingest_replays(res, options, on_replay, stats);
+			sqlite3_finalize(res);
+		}
+		if(!ok) {
+			return 1;
+		}
+
+		std::cout << "Round " << round << ": " << stats.seconds << "s" << std::endl;
+
+		total.rows += stats.rows;
+		total.bytes_read += stats.bytes_read;
+		total.bytes_inflated += stats.bytes_inflated;
+		total.frames += stats.frames;
+		total.failed += stats.failed;
+		total.guessed += stats.guessed;
+		for(size_t i = 0; i < NINJI_DECODE_ERROR_COUNT; i++) {
+			total.malformed[i] += stats.malformed[i];
+		}
+		total.seconds += stats.seconds;
+	}
+
+	sqlite3_close(db);
+
+	std::cout << threads << " threads, " << shards << " shards, " << (stream ? "streaming" : "whole blobs") << ", "
+			  << rounds << " rounds" << std::endl;
+	std::cout << total.rows / total.seconds << " rows/s, " << total.bytes_read / 1000000.0 / total.seconds
+			  << " MB/s read, " << total.bytes_inflated / 1000000.0 / total.seconds << " MB/s inflated, "
+			  << total.frames / total.seconds << " frames/s decoded" << std::endl;
+	if(total.failed) {
+		std::cout << "Could not decode " << total.failed << " replays" << std::endl;
+	}
+	print_decode_problems(total);
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+// Compares the memory and per frame read cost of compressed paths against the decoded frame arrays, using every
+// replay in a database such as one made by gen_ninji_db
+// Usage: bench_paths <db> [rounds]
+
+#include "compressed_path.hpp"
+#include "ingest.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+// Sums every field so the reads can't be optimized away
+static uint64_t sum_frame(const NinjiFrame& frame) {
+	return frame.x + frame.y + frame.state + frame.flags;
+}
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::cout << "Usage: bench_paths <db> [rounds]" << std::endl;
+		return 1;
+	}
+
+	int rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+	DatabaseOptions database_options;
+	database_options.immutable = true;
+
+	sqlite3* db;
+	if(!open_database(argv[1], database_options, &db)) {
+		return 1;
+	}
+
+	sqlite3_stmt* res;
+	if(sqlite3_prepare_v2(db, "SELECT data_id,pid,time,replay FROM ninji", -1, &res, 0) != SQLITE_OK) {
+		std::cout << "Sqlite could not prepare query: " << sqlite3_errmsg(db) << std::endl;
+		return 1;
+	}
+
+	IngestOptions options;
+	options.num_workers = std::thread::hardware_concurrency();
+
+	LevelFrames frames;
+	IngestStats stats;
+	bool ok = ingest_replays(
+		res, options,
+		[&](IngestedReplay& replay) {
+			frames.add_path();
+			frames.append(replay.frames);
+			return true;
+		},
+		stats);
+	sqlite3_finalize(res);
+	sqlite3_close(db);
+	if(!ok) {
+		return 1;
+	}
+
+	auto compress_start = std::chrono::steady_clock::now();
+	CompressedPaths compressed;
+	compressed.build(frames);
+	double compress_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - compress_start).count();
+
+	size_t num_frames = frames.num_frames();
+	std::cout << frames.num_paths() << " paths, " << num_frames << " frames, compressed in " << compress_seconds
+			  << "s" << std::endl;
+	std::cout << "NinjiFrame arrays: " << num_frames * sizeof(NinjiFrame) / 1000000.0 << " MB, field arrays: "
+			  << num_frames * 6 / 1000000.0 << " MB, compressed: " << compressed.size_bytes() / 1000000.0 << " MB ("
+			  << (double)compressed.size_bytes() / num_frames << " bytes per frame)" << std::endl;
+
+	// Each pass reads every frame of every path in order, the way the render loop walks player_update
+	double array_seconds  = 0;
+	double cursor_seconds = 0;
+	double decode_seconds = 0;
+	uint64_t array_sum    = 0;
+	uint64_t cursor_sum   = 0;
+	uint64_t decode_sum   = 0;
+	DecodedPath decoded;
+	for(int round = 0; round < rounds; round++) {
+		auto start = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < frames.num_paths(); i++) {
+			auto path = frames.path(i);
+			for(size_t frame = 0; frame < path.size(); frame++) {
+				array_sum += sum_frame(path[frame]);
+			}
+		}
+		array_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < compressed.num_paths(); i++) {
+			auto cursor = compressed.cursor(i);
+			NinjiFrame frame;
+			for(uint32_t t = 0; t < cursor.size(); t++) {
+				cursor.seek(t);
+				cursor.current(frame);
+				cursor_sum += sum_frame(frame);
+			}
+		}
+		cursor_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		for(uint32_t i = 0; i < compressed.num_paths(); i++) {
+			compressed.decode(i, decoded);
+			auto path = decoded.view();
+			for(size_t frame = 0; frame < path.size(); frame++) {
+				decode_sum += sum_frame(path[frame]);
+			}
+		}
+		decode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if(array_sum != cursor_sum || array_sum != decode_sum) {
+		std::cout << "Compressed paths do not match the decoded frames" << std::endl;
+		return 1;
+	}
+
+	double frames_read = (double)num_frames * rounds;
+	std::cout << "Field arrays: " << array_seconds * 1e9 / frames_read << " ns per frame" << std::endl;
+	std::cout << "Cursor: " << cursor_seconds * 1e9 / frames_read << " ns per frame" << std::endl;
+	std::cout << "Whole path decode: " << decode_seconds * 1e9 / frames_read << " ns per frame" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,215 @@
+// Generates a database with the ninji and user tables main() reads, filled with random but well formed replays
+// Usage: gen_ninji_db <db> [levels] [players] [replays per level] [average frames] [seed] [guessed percent]
+
+#include "replay.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+static const char* COUNTRIES[] = { "US", "JP", "FR", "DE", "GB", "CA", "MX", "ES", "IT", "AU", "BR", "KR" };
+
+// Frame layout matches NINJI_FRAME_LAYOUTS, 5 bytes when flags don't have 0b110 set, otherwise a sixth byte decides
+// between 6 and 8. Only replays with guessed set use the undocumented unk1 values
+static void append_frame(
+	std::vector<uint8_t>& replay, std::mt19937& rng, uint8_t state, uint16_t x, uint16_t y, bool guessed) {
+	static const uint8_t FLAGS[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 2, 4 };
+	uint8_t flags                = FLAGS[rng() % 16];
+	replay.push_back((flags << 4) | state);
+
+	uint8_t position[4];
+	memcpy(&position[0], &x, sizeof(x));
+	memcpy(&position[2], &y, sizeof(y));
+	replay.insert(replay.end(), position, position + 4);
+
+	if(flags & 0b110) {
+		static const uint8_t UNK1[] = { 0, 8, 16, 2 };
+		uint8_t unk1                = UNK1[rng() % (guessed ? 4 : 3)];
+		replay.push_back(unk1);
+		if(!(unk1 & 0b110) && (unk1 & 0b11000)) {
+			replay.push_back(rng());
+			replay.push_back(rng());
+		}
+	}
+}
+
+static std::vector<uint8_t> generate_replay(std::mt19937& rng, int num_frames, bool guessed) {
+	std::vector<uint8_t> replay(NINJI_HEADER_SIZE);
+
+	// Recorded frame count is big endian and two less than 4 times the ghost frames
+	uint32_t recorded_frames = num_frames * 4 - 2;
+	replay[0x10]             = recorded_frames >> 24;
+	replay[0x11]             = recorded_frames >> 16;
+	replay[0x12]             = recorded_frames >> 8;
+	replay[0x13]             = recorded_frames;
+	replay[0x14]             = rng() % 4;
+
+	// A run moving mostly right at a steady speed, states and velocities last a while like real ghosts
+	int x     = 1000 + rng() % 500;
+	int y     = 1000 + rng() % 500;
+	int dx    = 8;
+	int dy    = 0;
+	int state = 0;
+	for(int i = 0; i < num_frames; i++) {
+		if(rng() % 16 == 0) {
+			state = rng() % 13;
+			dx    = (int)(rng() % 24) - 4;
+			dy    = (int)(rng() % 17) - 8;
+		}
+		x = (x + dx) & 0xFFFF;
+		y = (y + dy) & 0xFFFF;
+		append_frame(replay, rng, state, x, y, guessed);
+	}
+
+	// Real replays sometimes carry bytes past the last frame
+	int extra = rng() % 4 == 0 ? rng() % 32 : 0;
+	for(int i = 0; i < extra; i++) {
+		replay.push_back(rng());
+	}
+
+	return replay;
+}
+
+static bool gzip_compress(const std::vector<uint8_t>& input, std::vector<uint8_t>& output) {
+	z_stream strm {};
+	if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+
+	output.resize(deflateBound(&strm, input.size()));
+	strm.next_in   = (Bytef*)input.data();
+	strm.avail_in  = input.size();
+	strm.next_out  = output.data();
+	strm.avail_out = output.size();
+
+	int err = deflate(&strm, Z_FINISH);
+	output.resize(strm.total_out);
+	deflateEnd(&strm);
+	return err == Z_STREAM_END;
+}
+
+static std::string random_pid(std::mt19937_64& rng) {
+	static const char* hex = "0123456789abcdef";
+	uint64_t value         = rng();
+	std::string pid(16, '0');
+	for(int i = 15; i >= 0; i--) {
+		pid[i] = hex[value & 0xF];
+		value >>= 4;
+	}
+	return pid;
+}
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::cout << "Usage: gen_ninji_db <db> [levels] [players] [replays per level] [average frames] [seed] "
+					 "[guessed percent]"
+				  << std::endl;
+		return 1;
+	}
+
+	int num_levels        = argc > 2 ? atoi(argv[2]) : 4;
+	int num_players       = argc > 3 ? atoi(argv[3]) : 20000;
+	int replays_per_level = argc > 4 ? atoi(argv[4]) : 10000;
+	int average_frames    = argc > 5 ? atoi(argv[5]) : 600;
+	uint32_t seed         = argc > 6 ? atoi(argv[6]) : 1;
+	// Share of replays with frames in the undocumented unk1 layout the decoder has to guess the size of
+	int guessed_percent = argc > 7 ? atoi(argv[7]) : 1;
+
+	if(num_levels <= 0 || num_players <= 0 || replays_per_level <= 0 || average_frames <= 0) {
+		std::cout << "Counts must be positive" << std::endl;
+		return 1;
+	}
+
+	std::error_code ec;
+	std::filesystem::remove(argv[1], ec);
+
+	sqlite3* db;
+	if(sqlite3_open(argv[1], &db) != SQLITE_OK) {
+		std::cout << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
+		return 1;
+	}
+
+	char* err_msg = nullptr;
+	if(sqlite3_exec(db,
+		   "PRAGMA journal_mode = OFF;"
+		   "PRAGMA synchronous = OFF;"
+		   "CREATE TABLE ninji(data_id INTEGER, pid TEXT, time INTEGER, replay BLOB);"
+		   "CREATE TABLE user(pid TEXT PRIMARY KEY, name TEXT, code TEXT, country TEXT, mii_image TEXT);"
+		   "BEGIN",
+		   NULL, NULL, &err_msg)
+		!= SQLITE_OK) {
+		std::cout << "Cannot create tables: " << err_msg << std::endl;
+		return 1;
+	}
+
+	std::mt19937 rng(seed);
+	std::mt19937_64 pid_rng(seed);
+
+	std::vector<std::string> pids;
+	pids.reserve(num_players);
+	for(int i = 0; i < num_players; i++) {
+		pids.push_back(random_pid(pid_rng));
+	}
+
+	sqlite3_stmt* insert_user;
+	sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO user VALUES (?,?,?,?,?)", -1, &insert_user, 0);
+	for(auto& pid : pids) {
+		std::string name      = "Player " + pid.substr(0, 6);
+		std::string code      = "M" + pid.substr(0, 8);
+		std::string mii_image = "https://mii-secure.cdn.nintendo.net/" + pid + "_normal_face.png";
+		sqlite3_bind_text(insert_user, 1, pid.c_str(), pid.size(), SQLITE_STATIC);
+		sqlite3_bind_text(insert_user, 2, name.c_str(), name.size(), SQLITE_STATIC);
+		sqlite3_bind_text(insert_user, 3, code.c_str(), code.size(), SQLITE_STATIC);
+		sqlite3_bind_text(insert_user, 4, COUNTRIES[rng() % std::size(COUNTRIES)], 2, SQLITE_STATIC);
+		sqlite3_bind_text(insert_user, 5, mii_image.c_str(), mii_image.size(), SQLITE_STATIC);
+		sqlite3_step(insert_user);
+		sqlite3_reset(insert_user);
+	}
+	sqlite3_finalize(insert_user);
+
+	sqlite3_stmt* insert_ninji;
+	sqlite3_prepare_v2(db, "INSERT INTO ninji VALUES (?,?,?,?)", -1, &insert_ninji, 0);
+
+	uint64_t replay_bytes     = 0;
+	uint64_t compressed_bytes = 0;
+	std::vector<uint8_t> compressed;
+	for(int level = 0; level < num_levels; level++) {
+		int data_id = 10000000 + level;
+		for(int i = 0; i < replays_per_level; i++) {
+			auto& pid      = pids[rng() % pids.size()];
+			int num_frames = average_frames / 2 + rng() % average_frames + 1;
+			bool guessed   = (int)(rng() % 100) < guessed_percent;
+			auto replay    = generate_replay(rng, num_frames, guessed);
+			if(!gzip_compress(replay, compressed)) {
+				std::cout << "Could not compress replay" << std::endl;
+				return 1;
+			}
+			replay_bytes += replay.size();
+			compressed_bytes += compressed.size();
+
+			sqlite3_bind_int(insert_ninji, 1, data_id);
+			sqlite3_bind_text(insert_ninji, 2, pid.c_str(), pid.size(), SQLITE_STATIC);
+			sqlite3_bind_int(insert_ninji, 3, 20000 + rng() % 200000);
+			sqlite3_bind_blob(insert_ninji, 4, compressed.data(), compressed.size(), SQLITE_STATIC);
+			sqlite3_step(insert_ninji);
+			sqlite3_reset(insert_ninji);
+		}
+		std::cout << "Generated level " << data_id << std::endl;
+	}
+	sqlite3_finalize(insert_ninji);
+
+	sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+	sqlite3_close(db);
+
+	std::cout << num_levels * (uint64_t)replays_per_level << " replays, " << replay_bytes / 1000000.0 << " MB, "
+			  << compressed_bytes / 1000000.0 << " MB compressed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+#include "band_renderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <core/SkCanvas.h>
+#include <cstring>
+#include <iostream>
+
+BandRenderer::BandRenderer(int num_bands) {
+	band_tops.resize(std::max(num_bands, 1));
+	surfaces.resize(band_tops.size());
+
+	for(int band = 1; band < (int)band_tops.size(); band++) {
+		workers.emplace_back([this, band] {
+			uint64_t rendered = 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			while(true) {
+				start.wait(lock, [&] { return stopping || generation != rendered; });
+				if(stopping) {
+					return;
+				}
+				rendered = generation;
+
+				lock.unlock();
+				render_band(band);
+				lock.lock();
+
+				if(--bands_left == 0) {
+					done.notify_one();
+				}
+			}
+		});
+	}
+}
+
+BandRenderer::~BandRenderer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	start.notify_all();
+	for(auto& worker : workers) {
+		worker.join();
+	}
+}
+
+bool BandRenderer::set_target(const SkImageInfo& info, uint8_t* pixels, size_t row_bytes) {
+	int num_bands = band_tops.size();
+	for(int band = 0; band < num_bands; band++) {
+		int top         = (int64_t)info.height() * band / num_bands;
+		int bottom      = (int64_t)info.height() * (band + 1) / num_bands;
+		band_tops[band] = top;
+		surfaces[band]  = nullptr;
+		if(bottom > top) {
+			surfaces[band] = SkSurface::MakeRasterDirect(
+				info.makeWH(info.width(), bottom - top), pixels + (size_t)top * row_bytes, row_bytes);
+			if(!surfaces[band]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void BandRenderer::render(const SkPicture* picture) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->picture = picture;
+		bands_left    = workers.size();
+		generation++;
+	}
+	start.notify_all();
+
+	render_band(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [&] { return bands_left == 0; });
+}
+
+void BandRenderer::render_band(int band) {
+	if(!surfaces[band]) {
+		return;
+	}
+
+	// The picture is in frame coordinates, the band's canvas starts at its top row. Playback culls the draws that
+	// miss the band's clip
+	SkCanvas* canvas = surfaces[band]->getCanvas();
+	canvas->save();
+	canvas->translate(0, -band_tops[band]);
+	picture->playback(canvas);
+	canvas->restore();
+}
+
+void report_band_scaling(const SkPicture* picture, const SkImageInfo& info, const uint8_t* pixels, size_t row_bytes,
+	int max_bands, int rounds) {
+	size_t size = row_bytes * info.height();
+	std::vector<uint8_t> expected(size);
+	std::vector<uint8_t> banded(size);
+
+	// One canvas over the whole frame, what the renderer does without bands
+	double serial_seconds = 0;
+	{
+		sk_sp<SkSurface> surface = SkSurface::MakeRasterDirect(info, expected.data(), row_bytes);
+		for(int round = 0; round < rounds; round++) {
+			memcpy(expected.data(), pixels, size);
+			auto start = std::chrono::steady_clock::now();
+			picture->playback(surface->getCanvas());
+			serial_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+	std::cout << "Serial: " << serial_seconds * 1000.0 / rounds << "ms per frame" << std::endl;
+
+	// Powers of two up to max_bands, and max_bands itself
+	for(int bands = 1;; bands = std::min(bands * 2, max_bands)) {
+		BandRenderer renderer(bands);
+		if(!renderer.set_target(info, banded.data(), row_bytes)) {
+			std::cout << "Could not create " << bands << " band surfaces" << std::endl;
+			return;
+		}
+
+		double seconds = 0;
+		for(int round = 0; round < rounds; round++) {
+			memcpy(banded.data(), pixels, size);
+			auto start = std::chrono::steady_clock::now();
+			renderer.render(picture);
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		bool identical = memcmp(banded.data(), expected.data(), size) == 0;
+		std::cout << bands << " bands: " << seconds * 1000.0 / rounds << "ms per frame, " << serial_seconds / seconds
+				  << "x serial, " << (identical ? "identical" : "DIFFERS from serial") << std::endl;
+
+		if(bands == max_bands) {
+			break;
+		}
+	}
+}
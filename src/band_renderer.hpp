@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <core/SkPicture.h>
+#include <core/SkSurface.h>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Plays a recorded frame back over horizontal bands of a raster buffer, each band on its own thread with its own canvas
+// over its rows of the shared buffer. Pictures recorded with a bounding box hierarchy only replay the draws that
+// intersect each band
+class BandRenderer {
+public:
+	// The calling thread renders the first band, num_bands - 1 workers render the rest
+	BandRenderer(int num_bands);
+	BandRenderer(const BandRenderer&) = delete;
+	BandRenderer& operator=(const BandRenderer&) = delete;
+	~BandRenderer();
+
+	// Splits the buffer into bands of whole rows, as even as the height allows
+	bool set_target(const SkImageInfo& info, uint8_t* pixels, size_t row_bytes);
+
+	// Draws picture over the buffer in device coordinates, returns once every band is done
+	void render(const SkPicture* picture);
+
+	int num_bands() const {
+		return band_tops.size();
+	}
+
+private:
+	void render_band(int band);
+
+	std::vector<sk_sp<SkSurface>> surfaces;
+	std::vector<int> band_tops;
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start;
+	std::condition_variable done;
+	const SkPicture* picture = nullptr;
+	// Bumped once per render so each worker renders its band once
+	uint64_t generation = 0;
+	int bands_left      = 0;
+	bool stopping       = false;
+};
+
+// Renders picture over a copy of pixels serially and then in 1 up to max_bands bands, rounds times each, and prints
+// the time per frame and whether each band count matches the serial render byte for byte
+void report_band_scaling(const SkPicture* picture, const SkImageInfo& info, const uint8_t* pixels, size_t row_bytes,
+	int max_bands, int rounds);
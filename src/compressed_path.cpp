@@ -0,0 +1,139 @@
+#include "compressed_path.hpp"
+
+// Deltas wrap around at 16 bits, so every delta fits an int16_t and zig-zags into at most 3 varint bytes
+static void write_varint(std::vector<uint8_t>& output, uint32_t value) {
+	while(value >= 0x80) {
+		output.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	output.push_back(value);
+}
+
+static uint32_t read_varint(const uint8_t*& input) {
+	uint32_t value = *input++;
+	if(value < 0x80) {
+		return value;
+	}
+	value &= 0x7F;
+	for(int shift = 7;; shift += 7) {
+		uint8_t byte = *input++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if(byte < 0x80) {
+			return value;
+		}
+	}
+}
+
+static void write_delta(std::vector<uint8_t>& output, uint16_t previous, uint16_t value) {
+	int16_t delta = (int16_t)(uint16_t)(value - previous);
+	write_varint(output, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 15));
+}
+
+static uint16_t read_delta(const uint8_t*& input, uint16_t previous) {
+	uint32_t zigzag = read_varint(input);
+	return previous + (uint16_t)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+}
+
+PathCursor::PathCursor(const uint8_t* positions, const uint8_t* runs, uint32_t num_frames)
+	: positions(positions)
+	, runs(runs)
+	, num_frames(num_frames) {
+	if(num_frames > 0) {
+		window[1] = decode_next();
+	}
+	if(num_frames > 1) {
+		window[2] = decode_next();
+	}
+}
+
+NinjiFrame PathCursor::decode_next() {
+	x = read_delta(positions, x);
+	y = read_delta(positions, y);
+	if(run_left == 0) {
+		run_left  = read_varint(runs);
+		run_state = *runs++;
+		run_flags = *runs++;
+	}
+	run_left--;
+	return NinjiFrame { run_state, x, y, run_flags };
+}
+
+void PathCursor::seek(uint32_t target) {
+	while(index < target) {
+		window[0] = window[1];
+		window[1] = window[2];
+		index++;
+		if(index + 1 < num_frames) {
+			window[2] = decode_next();
+		}
+	}
+}
+
+void CompressedPaths::build(const LevelFrames& frames) {
+	positions.clear();
+	runs.clear();
+	position_offsets.clear();
+	run_offsets.clear();
+	sizes.clear();
+
+	// Most frames take one byte per coordinate, reserving that up front avoids most regrowth
+	positions.reserve(frames.num_frames() * 2);
+	position_offsets.reserve(frames.num_paths() + 1);
+	run_offsets.reserve(frames.num_paths() + 1);
+	sizes.reserve(frames.num_paths());
+
+	for(uint32_t i = 0; i < frames.num_paths(); i++) {
+		auto path = frames.path(i);
+		position_offsets.push_back(positions.size());
+		run_offsets.push_back(runs.size());
+		sizes.push_back(path.size());
+
+		uint16_t x = 0;
+		uint16_t y = 0;
+		for(size_t frame = 0; frame < path.size(); frame++) {
+			write_delta(positions, x, path.x[frame]);
+			write_delta(positions, y, path.y[frame]);
+			x = path.x[frame];
+			y = path.y[frame];
+
+			if(frame == 0 || path.state[frame] != path.state[frame - 1] || path.flags[frame] != path.flags[frame - 1]) {
+				size_t run_end = frame + 1;
+				while(run_end < path.size() && path.state[run_end] == path.state[frame]
+					  && path.flags[run_end] == path.flags[frame]) {
+					run_end++;
+				}
+				write_varint(runs, run_end - frame);
+				runs.push_back(path.state[frame]);
+				runs.push_back(path.flags[frame]);
+			}
+		}
+	}
+
+	position_offsets.push_back(positions.size());
+	run_offsets.push_back(runs.size());
+	positions.shrink_to_fit();
+}
+
+void CompressedPaths::decode(uint32_t index, DecodedPath& decoded) const {
+	uint32_t size = sizes[index];
+	decoded.x.resize(size);
+	decoded.y.resize(size);
+	decoded.state.resize(size);
+	decoded.flags.resize(size);
+
+	auto cursor = this->cursor(index);
+	for(uint32_t frame = 0; frame < size; frame++) {
+		cursor.seek(frame);
+		NinjiFrame current;
+		cursor.current(current);
+		decoded.x[frame]     = current.x;
+		decoded.y[frame]     = current.y;
+		decoded.state[frame] = current.state;
+		decoded.flags[frame] = current.flags;
+	}
+}
+
+size_t CompressedPaths::size_bytes() const {
+	return positions.size() + runs.size() + (position_offsets.size() + run_offsets.size()) * sizeof(uint64_t)
+		   + sizes.size() * sizeof(uint32_t);
+}
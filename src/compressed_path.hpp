@@ -0,0 +1,81 @@
+#pragma once
+
+#include "frame_store.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Walks a compressed path forward one frame at a time, keeping the frames either side of the current one decoded
+class PathCursor {
+public:
+	PathCursor() = default;
+	PathCursor(const uint8_t* positions, const uint8_t* runs, uint32_t num_frames);
+
+	uint32_t size() const {
+		return num_frames;
+	}
+
+	// Moves forward until frame target is the current one, a cursor never goes back
+	void seek(uint32_t target);
+
+	// Each returns false when the frame lies outside the path
+	bool before(NinjiFrame& frame) const {
+		frame = window[0];
+		return index != 0 && index - 1 < num_frames;
+	}
+
+	bool current(NinjiFrame& frame) const {
+		frame = window[1];
+		return index < num_frames;
+	}
+
+	bool after(NinjiFrame& frame) const {
+		frame = window[2];
+		return index + 1 < num_frames;
+	}
+
+private:
+	NinjiFrame decode_next();
+
+	const uint8_t* positions = nullptr;
+	const uint8_t* runs      = nullptr;
+	uint32_t num_frames      = 0;
+	uint32_t index           = 0;
+
+	uint16_t x        = 0;
+	uint16_t y        = 0;
+	uint32_t run_left = 0;
+	uint8_t run_state = 0;
+	uint8_t run_flags = 0;
+	NinjiFrame window[3] {};
+};
+
+// Every path of a level with x and y stored as zig-zag varint deltas from the previous frame and state and flags run
+// length encoded. Ghosts move a few subpixels per frame, so most frames take 2 bytes instead of 6
+class CompressedPaths {
+public:
+	void build(const LevelFrames& frames);
+
+	uint32_t num_paths() const {
+		return sizes.size();
+	}
+
+	uint32_t path_size(uint32_t index) const {
+		return sizes[index];
+	}
+
+	PathCursor cursor(uint32_t index) const {
+		return PathCursor(positions.data() + position_offsets[index], runs.data() + run_offsets[index], sizes[index]);
+	}
+
+	void decode(uint32_t index, DecodedPath& decoded) const;
+
+	size_t size_bytes() const;
+
+private:
+	std::vector<uint8_t> positions;
+	std::vector<uint8_t> runs;
+	std::vector<uint64_t> position_offsets;
+	std::vector<uint64_t> run_offsets;
+	std::vector<uint32_t> sizes;
+};
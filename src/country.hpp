@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+// Every country with a flag in assets/flags, a country's id is its index
+constexpr char COUNTRY_CODES[][3] = {
+	"AC", "AD", "AE", "AF", "AG", "AI", "AL", "AM", "AO", "AQ", "AR", "AS", "AT", "AU", "AW", "AX", "AZ", "BA", "BB",
+	"BD", "BE", "BF", "BG", "BH", "BI", "BJ", "BL", "BM", "BN", "BO", "BQ", "BR", "BS", "BT", "BV", "BW", "BY", "BZ",
+	"CA", "CC", "CD", "CF", "CG", "CH", "CI", "CK", "CL", "CM", "CN", "CO", "CP", "CR", "CU", "CV", "CW", "CX", "CY",
+	"CZ", "DE", "DG", "DJ", "DK", "DM", "DO", "DZ", "EA", "EC", "EE", "EG", "EH", "ER", "ES", "ET", "EU", "FI", "FJ",
+	"FK", "FM", "FO", "FR", "GA", "GB", "GD", "GE", "GF", "GG", "GH", "GI", "GL", "GM", "GN", "GP", "GQ", "GR", "GS",
+	"GT", "GU", "GW", "GY", "HK", "HM", "HN", "HR", "HT", "HU", "IC", "ID", "IE", "IL", "IM", "IN", "IO", "IQ", "IR",
+	"IS", "IT", "JE", "JM", "JO", "JP", "KE", "KG", "KH", "KI", "KM", "KN", "KP", "KR", "KW", "KY", "KZ", "LA", "LB",
+	"LC", "LI", "LK", "LR", "LS", "LT", "LU", "LV", "LY", "MA", "MC", "MD", "ME", "MF", "MG", "MH", "MK", "ML", "MM",
+	"MN", "MO", "MP", "MQ", "MR", "MS", "MT", "MU", "MV", "MW", "MX", "MY", "MZ", "NA", "NC", "NE", "NF", "NG", "NI",
+	"NL", "NO", "NP", "NR", "NU", "NZ", "OM", "PA", "PE", "PF", "PG", "PH", "PK", "PL", "PM", "PN", "PR", "PS", "PT",
+	"PW", "PY", "QA", "RE", "RO", "RS", "RU", "RW", "SA", "SB", "SC", "SD", "SE", "SG", "SH", "SI", "SJ", "SK", "SL",
+	"SM", "SN", "SO", "SR", "SS", "ST", "SV", "SX", "SY", "SZ", "TA", "TC", "TD", "TF", "TG", "TH", "TJ", "TK", "TL",
+	"TM", "TN", "TO", "TR", "TT", "TV", "TW", "TZ", "UA", "UG", "UM", "UN", "US", "UY", "UZ", "VA", "VC", "VE", "VG",
+	"VI", "VN", "VU", "WF", "WS", "XK", "YE", "YT", "ZA", "ZM", "ZW"
+};
+
+constexpr uint16_t NUM_COUNTRIES = std::size(COUNTRY_CODES);
+// Id of codes missing from COUNTRY_CODES, which have no flag
+constexpr uint16_t COUNTRY_UNKNOWN = NUM_COUNTRIES;
+
+// Id of every two letter code, AA first and ZZ last, so interning is one load instead of hashing a string
+constexpr std::array<uint16_t, 26 * 26> COUNTRY_IDS = [] {
+	std::array<uint16_t, 26 * 26> ids {};
+	ids.fill(COUNTRY_UNKNOWN);
+	for(uint16_t id = 0; id < NUM_COUNTRIES; id++) {
+		ids[(COUNTRY_CODES[id][0] - 'A') * 26 + COUNTRY_CODES[id][1] - 'A'] = id;
+	}
+	return ids;
+}();
+
+constexpr uint16_t intern_country(std::string_view code) {
+	if(code.size() != 2 || code[0] < 'A' || code[0] > 'Z' || code[1] < 'A' || code[1] > 'Z') {
+		return COUNTRY_UNKNOWN;
+	}
+	return COUNTRY_IDS[(code[0] - 'A') * 26 + code[1] - 'A'];
+}
+
+constexpr std::string_view country_code(uint16_t id) {
+	return id < NUM_COUNTRIES ? std::string_view(COUNTRY_CODES[id], 2) : std::string_view();
+}
+
+static_assert(intern_country("AC") == 0 && intern_country("US") == 240 && intern_country("ZW") == NUM_COUNTRIES - 1);
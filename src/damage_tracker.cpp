@@ -0,0 +1,163 @@
+#include "damage_tracker.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// Small enough that a sprite damages a handful of tiles, large enough that a row run is a useful memcpy
+constexpr int DAMAGE_TILE_SIZE = 32;
+
+// Frames are RGBA 8888
+constexpr size_t DAMAGE_BYTES_PER_PIXEL = 4;
+
+void DamageTracker::reset(int width, int height) {
+	this->width  = width;
+	this->height = height;
+	columns      = (width + DAMAGE_TILE_SIZE - 1) / DAMAGE_TILE_SIZE;
+	rows         = (height + DAMAGE_TILE_SIZE - 1) / DAMAGE_TILE_SIZE;
+	damaged.assign((size_t)columns * rows, 1);
+	restored_tiles.assign((size_t)columns * rows, 0);
+}
+
+void DamageTracker::add(int left, int top, int right, int bottom) {
+	left   = std::max(left, 0);
+	top    = std::max(top, 0);
+	right  = std::min(right, width);
+	bottom = std::min(bottom, height);
+	if(left >= right || top >= bottom) {
+		return;
+	}
+
+	int first_column = left / DAMAGE_TILE_SIZE;
+	int last_column  = (right - 1) / DAMAGE_TILE_SIZE;
+	for(int row = top / DAMAGE_TILE_SIZE; row <= (bottom - 1) / DAMAGE_TILE_SIZE; row++) {
+		std::fill(&damaged[(size_t)row * columns + first_column], &damaged[(size_t)row * columns + last_column] + 1, 1);
+	}
+}
+
+void DamageTracker::add_all() {
+	std::fill(damaged.begin(), damaged.end(), 1);
+}
+
+size_t DamageTracker::restore(uint8_t* pixels, const uint8_t* background, size_t row_bytes) {
+	size_t copied = 0;
+	for(int row = 0; row < rows; row++) {
+		const uint8_t* tiles = &damaged[(size_t)row * columns];
+		for(int column = 0; column < columns;) {
+			if(!tiles[column]) {
+				column++;
+				continue;
+			}
+
+			// Neighbouring damaged tiles are copied as one run per pixel row
+			int run_end = column + 1;
+			while(run_end < columns && tiles[run_end]) {
+				run_end++;
+			}
+
+			int left   = column * DAMAGE_TILE_SIZE;
+			int right  = std::min(run_end * DAMAGE_TILE_SIZE, width);
+			int top    = row * DAMAGE_TILE_SIZE;
+			int bottom = std::min(top + DAMAGE_TILE_SIZE, height);
+			restore_rect(pixels, background, row_bytes, left, top, right, bottom);
+			copied += (size_t)(right - left) * (bottom - top);
+			column = run_end;
+		}
+	}
+
+	std::swap(damaged, restored_tiles);
+	std::fill(damaged.begin(), damaged.end(), 0);
+	return copied;
+}
+
+void DamageTracker::restore_rect(uint8_t* pixels, const uint8_t* background, size_t row_bytes, int left, int top,
+	int right, int bottom) const {
+	left   = std::max(left, 0);
+	top    = std::max(top, 0);
+	right  = std::min(right, width);
+	bottom = std::min(bottom, height);
+	if(left >= right) {
+		return;
+	}
+
+	size_t offset = left * DAMAGE_BYTES_PER_PIXEL;
+	size_t size   = (right - left) * DAMAGE_BYTES_PER_PIXEL;
+	for(int y = top; y < bottom; y++) {
+		memcpy(pixels + y * row_bytes + offset, background + y * row_bytes + offset, size);
+	}
+}
+
+bool DamageTracker::restored(int left, int top, int right, int bottom) const {
+	return restored(left, top, right, bottom, DamageRect { 0, 0, 0, 0 });
+}
+
+bool DamageTracker::restored(int left, int top, int right, int bottom, const DamageRect& excluded) const {
+	left   = std::max(left, 0);
+	top    = std::max(top, 0);
+	right  = std::min(right, width);
+	bottom = std::min(bottom, height);
+	if(left >= right || top >= bottom) {
+		return false;
+	}
+
+	// An empty exclusion is a range no tile falls in
+	bool has_excluded         = excluded.left < excluded.right && excluded.top < excluded.bottom;
+	int first_excluded_column = has_excluded ? excluded.left / DAMAGE_TILE_SIZE : 0;
+	int last_excluded_column  = has_excluded ? (excluded.right - 1) / DAMAGE_TILE_SIZE : -1;
+	int first_excluded_row    = has_excluded ? excluded.top / DAMAGE_TILE_SIZE : 0;
+	int last_excluded_row     = has_excluded ? (excluded.bottom - 1) / DAMAGE_TILE_SIZE : -1;
+
+	int first_column = left / DAMAGE_TILE_SIZE;
+	int last_column  = (right - 1) / DAMAGE_TILE_SIZE;
+	for(int row = top / DAMAGE_TILE_SIZE; row <= (bottom - 1) / DAMAGE_TILE_SIZE; row++) {
+		bool excluded_row = row >= first_excluded_row && row <= last_excluded_row;
+		for(int column = first_column; column <= last_column; column++) {
+			if(excluded_row && column >= first_excluded_column && column <= last_excluded_column) {
+				continue;
+			}
+			if(restored_tiles[(size_t)row * columns + column]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+DamageRect DamageTracker::tile_bounds(int left, int top, int right, int bottom) const {
+	left   = std::max(left, 0);
+	top    = std::max(top, 0);
+	right  = std::min(right, width);
+	bottom = std::min(bottom, height);
+	if(left >= right || top >= bottom) {
+		return DamageRect { 0, 0, 0, 0 };
+	}
+
+	return DamageRect { left / DAMAGE_TILE_SIZE * DAMAGE_TILE_SIZE, top / DAMAGE_TILE_SIZE * DAMAGE_TILE_SIZE,
+		std::min((right - 1) / DAMAGE_TILE_SIZE * DAMAGE_TILE_SIZE + DAMAGE_TILE_SIZE, width),
+		std::min((bottom - 1) / DAMAGE_TILE_SIZE * DAMAGE_TILE_SIZE + DAMAGE_TILE_SIZE, height) };
+}
+
+void DamageTracker::append_runs(const std::vector<uint8_t>& tiles, std::vector<DamageRect>& rects) const {
+	for(int row = 0; row < rows; row++) {
+		for(int column = 0; column < columns;) {
+			if(!tiles[(size_t)row * columns + column]) {
+				column++;
+				continue;
+			}
+			int run_end = column + 1;
+			while(run_end < columns && tiles[(size_t)row * columns + run_end]) {
+				run_end++;
+			}
+			rects.push_back(DamageRect { column * DAMAGE_TILE_SIZE, row * DAMAGE_TILE_SIZE,
+				std::min(run_end * DAMAGE_TILE_SIZE, width), std::min((row + 1) * DAMAGE_TILE_SIZE, height) });
+			column = run_end;
+		}
+	}
+}
+
+void DamageTracker::restored_rects(std::vector<DamageRect>& rects) const {
+	append_runs(restored_tiles, rects);
+}
+
+void DamageTracker::damaged_rects(std::vector<DamageRect>& rects) const {
+	append_runs(damaged, rects);
+}
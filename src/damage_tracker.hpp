@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tile aligned rectangle in pixels, right and bottom exclusive
+struct DamageRect {
+	int left;
+	int top;
+	int right;
+	int bottom;
+};
+
+// Tracks which tiles of a frame were drawn over since the static layer was copied in. A frame only restores the
+// tiles the previous frame drew on instead of the whole static layer, and what it draws is restored by the next one
+class DamageTracker {
+public:
+	// Starts with every tile damaged, so the first restore copies the whole static layer
+	void reset(int width, int height);
+
+	// Damages every tile touched by the rectangle, clipped to the frame
+	void add(int left, int top, int right, int bottom);
+
+	void add_all();
+
+	// Copies the tiles damaged since the last restore from background into pixels and starts a new frame. Returns the
+	// number of pixels copied
+	size_t restore(uint8_t* pixels, const uint8_t* background, size_t row_bytes);
+
+	// Copies a rectangle from background regardless of damage, for content that stays across frames and is redrawn
+	void restore_rect(uint8_t* pixels, const uint8_t* background, size_t row_bytes, int left, int top, int right,
+		int bottom) const;
+
+	// Whether the last restore copied any tile touching the rectangle
+	bool restored(int left, int top, int right, int bottom) const;
+	// Same, but tiles touching excluded don't count
+	bool restored(int left, int top, int right, int bottom, const DamageRect& excluded) const;
+
+	// Tiles touching the rectangle as one tile aligned rectangle, clipped to the frame
+	DamageRect tile_bounds(int left, int top, int right, int bottom) const;
+
+	// Runs of tiles restored by the last restore and damaged since, one rectangle per run of a tile row
+	void restored_rects(std::vector<DamageRect>& rects) const;
+	void damaged_rects(std::vector<DamageRect>& rects) const;
+
+private:
+	void append_runs(const std::vector<uint8_t>& tiles, std::vector<DamageRect>& rects) const;
+
+	int width   = 0;
+	int height  = 0;
+	int columns = 0;
+	int rows    = 0;
+	// One byte per tile, row major
+	std::vector<uint8_t> damaged;
+	std::vector<uint8_t> restored_tiles;
+};
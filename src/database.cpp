@@ -0,0 +1,115 @@
+#include "database.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+// Prefetched at once, the thread stays one window ahead of the pages it has already faulted in
+constexpr size_t PREFETCH_WINDOW_SIZE = 32 * 1024 * 1024;
+
+static std::string get_database_uri(const std::string& path) {
+	std::string uri = "file:";
+	for(char c : path) {
+		if(c == '?' || c == '#' || c == '%') {
+			static const char* hex = "0123456789ABCDEF";
+			uri += '%';
+			uri += hex[(uint8_t)c >> 4];
+			uri += hex[(uint8_t)c & 0xF];
+		} else if(c == '\\') {
+			uri += '/';
+		} else {
+			uri += c;
+		}
+	}
+	return uri + "?immutable=1";
+}
+
+bool open_database(const std::string& path, const DatabaseOptions& options, sqlite3** db) {
+	int flags = options.single_thread ? SQLITE_OPEN_NOMUTEX : 0;
+	int rc;
+	if(options.immutable) {
+		flags |= SQLITE_OPEN_READONLY | SQLITE_OPEN_URI;
+		rc = sqlite3_open_v2(get_database_uri(path).c_str(), db, flags, NULL);
+	} else {
+		flags |= options.read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+		rc = sqlite3_open_v2(path.c_str(), db, flags, NULL);
+	}
+
+	if(rc != SQLITE_OK) {
+		std::cout << "Cannot open database " << path << ": " << sqlite3_errmsg(*db) << std::endl;
+		sqlite3_close(*db);
+		*db = nullptr;
+		return false;
+	}
+
+	std::string pragmas = "PRAGMA cache_size = -" + std::to_string(options.cache_size_mb * 1024) + ";";
+	if(options.immutable) {
+		// SQLite clamps this to its compile time SQLITE_MAX_MMAP_SIZE
+		std::error_code ec;
+		uint64_t db_size = std::filesystem::file_size(path, ec);
+		if(!ec) {
+			pragmas += "PRAGMA mmap_size = " + std::to_string(db_size) + ";";
+		}
+	}
+
+	char* err_msg = nullptr;
+	if(sqlite3_exec(*db, pragmas.c_str(), NULL, NULL, &err_msg) != SQLITE_OK) {
+		// Only tuning, the database is still usable
+		std::cout << "Could not configure database: " << err_msg << std::endl;
+		sqlite3_free(err_msg);
+	}
+
+	return true;
+}
+
+bool has_index(sqlite3* db, const char* name) {
+	sqlite3_stmt* res;
+	if(sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = ?", -1, &res, 0)
+		!= SQLITE_OK) {
+		std::cout << "Sqlite could not prepare index query: " << sqlite3_errmsg(db) << std::endl;
+		return false;
+	}
+	sqlite3_bind_text(res, 1, name, -1, SQLITE_STATIC);
+	bool found = sqlite3_step(res) == SQLITE_ROW;
+	sqlite3_finalize(res);
+	return found;
+}
+
+DatabasePrefetcher::~DatabasePrefetcher() {
+	stop();
+}
+
+bool DatabasePrefetcher::start(const std::string& path) {
+	stop();
+
+	if(!file.open(path)) {
+		return false;
+	}
+
+	stopping = false;
+	thread   = std::thread([this] {
+		file.prefetch(0, PREFETCH_WINDOW_SIZE);
+		for(size_t offset = 0; offset < file.size() && !stopping; offset += PREFETCH_WINDOW_SIZE) {
+			file.prefetch(offset + PREFETCH_WINDOW_SIZE, PREFETCH_WINDOW_SIZE);
+
+			// Fault the current window in so the thread only runs as fast as the disk and never advises the whole file
+			// at once
+			size_t end    = std::min(offset + PREFETCH_WINDOW_SIZE, file.size());
+			uint8_t touch = 0;
+			for(size_t page = offset; page < end && !stopping; page += 4096) {
+				touch ^= ((volatile const uint8_t*)file.data())[page];
+			}
+			(void)touch;
+		}
+	});
+
+	return true;
+}
+
+void DatabasePrefetcher::stop() {
+	stopping = true;
+	if(thread.joinable()) {
+		thread.join();
+	}
+	file.close();
+}
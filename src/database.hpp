@@ -0,0 +1,51 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <thread>
+
+struct DatabaseOptions {
+	bool read_only = false;
+	// The dump is never modified while rendering, so SQLite can skip locking and change detection entirely. Implies
+	// read_only
+	bool immutable = false;
+	// Connection is only used from one thread, skips SQLite's per connection mutex
+	bool single_thread = false;
+	// Page cache per connection, most reads go through the memory map when immutable so this can stay small
+	int cache_size_mb = 64;
+};
+
+// Opens path, for an immutable database through a file: URI with mmap_size set to the whole file
+bool open_database(const std::string& path, const DatabaseOptions& options, sqlite3** db);
+
+// Whether db has an index called name, false if the schema couldn't be read
+bool has_index(sqlite3* db, const char* name);
+
+// Text of a column without copying it, valid until stmt is stepped again
+inline std::string_view column_string_view(sqlite3_stmt* stmt, int column) {
+	const char* text = (const char*)sqlite3_column_text(stmt, column);
+	return text ? std::string_view(text, sqlite3_column_bytes(stmt, column)) : std::string_view();
+}
+
+// Walks the database file ahead of ingest on a background thread, asking the OS to page it in so SQLite rarely
+// waits on a disk read
+class DatabasePrefetcher {
+public:
+	DatabasePrefetcher() = default;
+	DatabasePrefetcher(const DatabasePrefetcher&) = delete;
+	DatabasePrefetcher& operator=(const DatabasePrefetcher&) = delete;
+	~DatabasePrefetcher();
+
+	bool start(const std::string& path);
+	void stop();
+
+private:
+	MappedFile file;
+	std::thread thread;
+	std::atomic<bool> stopping { false };
+};
@@ -0,0 +1,101 @@
+#include "frame_store.hpp"
+
+#include <algorithm>
+
+LevelFrames::LevelFrames()
+	: offsets_owned(1, 0) {
+	update_views();
+}
+
+void LevelFrames::reserve(size_t num_paths, size_t num_frames) {
+	offsets_owned.reserve(num_paths + 1);
+	x_owned.reserve(num_frames);
+	y_owned.reserve(num_frames);
+	state_owned.reserve(num_frames);
+	flags_owned.reserve(num_frames);
+}
+
+uint32_t LevelFrames::add_path() {
+	offsets_owned.push_back(x_owned.size());
+	update_views();
+	return offsets_owned.size() - 2;
+}
+
+void LevelFrames::append(std::span<const NinjiFrame> frames) {
+	size_t num_frames = x_owned.size() + frames.size();
+	if(num_frames > x_owned.capacity()) {
+		// Half again rather than doubling, only one array is ever being copied while growing
+		size_t capacity = std::max(num_frames, x_owned.capacity() + x_owned.capacity() / 2);
+		x_owned.reserve(capacity);
+		y_owned.reserve(capacity);
+		state_owned.reserve(capacity);
+		flags_owned.reserve(capacity);
+	}
+
+	for(auto& frame : frames) {
+		x_owned.push_back(frame.x);
+		y_owned.push_back(frame.y);
+		state_owned.push_back(frame.state);
+		flags_owned.push_back(frame.flags);
+	}
+	offsets_owned.back() = x_owned.size();
+	update_views();
+}
+
+void LevelFrames::compact(std::span<const uint8_t> keep) {
+	size_t num_frames = 0;
+	size_t num_paths  = 0;
+	for(size_t path = 0; path + 1 < offsets_owned.size(); path++) {
+		if(!keep[path]) {
+			continue;
+		}
+		// Kept frames only ever move towards the front, so copying forwards never overwrites one not yet moved
+		uint32_t begin = offsets_owned[path];
+		uint32_t end   = offsets_owned[path + 1];
+		std::copy(x_owned.begin() + begin, x_owned.begin() + end, x_owned.begin() + num_frames);
+		std::copy(y_owned.begin() + begin, y_owned.begin() + end, y_owned.begin() + num_frames);
+		std::copy(state_owned.begin() + begin, state_owned.begin() + end, state_owned.begin() + num_frames);
+		std::copy(flags_owned.begin() + begin, flags_owned.begin() + end, flags_owned.begin() + num_frames);
+		num_frames += end - begin;
+		offsets_owned[++num_paths] = num_frames;
+	}
+
+	offsets_owned.resize(num_paths + 1);
+	x_owned.resize(num_frames);
+	y_owned.resize(num_frames);
+	state_owned.resize(num_frames);
+	flags_owned.resize(num_frames);
+	update_views();
+}
+
+void LevelFrames::shrink_to_fit() {
+	offsets_owned.shrink_to_fit();
+	x_owned.shrink_to_fit();
+	y_owned.shrink_to_fit();
+	state_owned.shrink_to_fit();
+	flags_owned.shrink_to_fit();
+	update_views();
+}
+
+void LevelFrames::view(std::span<const uint32_t> offsets, std::span<const uint16_t> x, std::span<const uint16_t> y,
+	std::span<const uint8_t> state, std::span<const uint8_t> flags) {
+	offsets_owned = {};
+	x_owned       = {};
+	y_owned       = {};
+	state_owned   = {};
+	flags_owned   = {};
+
+	offsets_view = offsets;
+	x_view       = x;
+	y_view       = y;
+	state_view   = state;
+	flags_view   = flags;
+}
+
+void LevelFrames::update_views() {
+	offsets_view = offsets_owned;
+	x_view       = x_owned;
+	y_view       = y_owned;
+	state_view   = state_owned;
+	flags_view   = flags_owned;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "replay.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// One path with every field in its own array
+struct NinjiPath {
+	std::span<const uint16_t> x;
+	std::span<const uint16_t> y;
+	std::span<const uint8_t> state;
+	std::span<const uint8_t> flags;
+
+	size_t size() const {
+		return x.size();
+	}
+
+	NinjiFrame operator[](size_t i) const {
+		return NinjiFrame { state[i], x[i], y[i], flags[i] };
+	}
+};
+
+// Decoded copy of one path from a store without random access, reused from path to path
+struct DecodedPath {
+	std::vector<uint16_t> x;
+	std::vector<uint16_t> y;
+	std::vector<uint8_t> state;
+	std::vector<uint8_t> flags;
+
+	NinjiPath view() const {
+		return NinjiPath { x, y, state, flags };
+	}
+};
+
+// Every path of a level stored CSR style, one contiguous array per field with the paths back to back. Path i covers
+// [offsets[i], offsets[i + 1]) of each field. The arrays are either owned or borrowed from memory that outlives the
+// store, such as a memory mapped replay cache
+class LevelFrames {
+public:
+	LevelFrames();
+	// Views point into the owned arrays, which keep their buffers when moved but not when copied
+	LevelFrames(const LevelFrames&) = delete;
+	LevelFrames& operator=(const LevelFrames&) = delete;
+	LevelFrames(LevelFrames&&) = default;
+	LevelFrames& operator=(LevelFrames&&) = default;
+
+	// Sizes the owned arrays once so adding paths never reallocates
+	void reserve(size_t num_paths, size_t num_frames);
+
+	// Starts a new path at the end and returns its index, append adds frames to it. Without a reserve covering them
+	// the arrays grow by half at a time, one array after another
+	uint32_t add_path();
+	void append(std::span<const NinjiFrame> frames);
+
+	// Drops the paths whose keep is 0 and moves the rest down in place, so no second copy of the arrays is made
+	void compact(std::span<const uint8_t> keep);
+
+	// Gives back capacity left over from growing, one array at a time
+	void shrink_to_fit();
+
+	// Drops the owned arrays and serves the given ones instead
+	void view(std::span<const uint32_t> offsets, std::span<const uint16_t> x, std::span<const uint16_t> y,
+		std::span<const uint8_t> state, std::span<const uint8_t> flags);
+
+	uint32_t num_paths() const {
+		return offsets_view.size() - 1;
+	}
+
+	size_t num_frames() const {
+		return x_view.size();
+	}
+
+	NinjiPath path(uint32_t index) const {
+		uint32_t begin = offsets_view[index];
+		uint32_t count = offsets_view[index + 1] - begin;
+		return NinjiPath { x_view.subspan(begin, count), y_view.subspan(begin, count), state_view.subspan(begin, count),
+			flags_view.subspan(begin, count) };
+	}
+
+	std::span<const uint32_t> offsets() const {
+		return offsets_view;
+	}
+
+	std::span<const uint16_t> x() const {
+		return x_view;
+	}
+
+	std::span<const uint16_t> y() const {
+		return y_view;
+	}
+
+	std::span<const uint8_t> state() const {
+		return state_view;
+	}
+
+	std::span<const uint8_t> flags() const {
+		return flags_view;
+	}
+
+private:
+	void update_views();
+
+	std::vector<uint32_t> offsets_owned;
+	std::vector<uint16_t> x_owned;
+	std::vector<uint16_t> y_owned;
+	std::vector<uint8_t> state_owned;
+	std::vector<uint8_t> flags_owned;
+
+	std::span<const uint32_t> offsets_view;
+	std::span<const uint16_t> x_view;
+	std::span<const uint16_t> y_view;
+	std::span<const uint8_t> state_view;
+	std::span<const uint8_t> flags_view;
+};
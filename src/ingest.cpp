@@ -0,0 +1,681 @@
+#include "ingest.hpp"
+#include "work_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+
+// Rows handed to a worker at once, large enough that queue traffic is noise next to inflating
+constexpr size_t INGEST_BATCH_SIZE = 256;
+
+// Rowid ranges per shard connection when scanning sharded, small ranges keep the shards busy when matching rows are
+// clustered in part of the table
+constexpr int INGEST_RANGES_PER_SHARD = 16;
+
+struct RawReplay {
+	int data_id;
+	std::string pid;
+	int time;
+	// Only one of these is used, depending on IngestOptions::stream_replays
+	std::vector<uint8_t> replay;
+	sqlite3_int64 rowid;
+};
+
+struct RawBatch {
+	uint32_t range = 0;
+	uint32_t index = 0;
+	std::vector<RawReplay> rows;
+};
+
+static uint64_t batch_key(uint32_t range, uint32_t index) {
+	return ((uint64_t)range << 32) | index;
+}
+
+// Readers push batches tagged with the range they were read from and their index within it, workers decode them in
+// any order and the merge on the calling thread releases them range by range, batch by batch. The result only depends
+// on how the rows were split into ranges, never on timing or the number of threads
+class IngestPipeline {
+public:
+	IngestPipeline(const IngestOptions& options)
+		: options(options)
+		, num_workers(std::max(options.num_workers, 1))
+		, max_in_flight(num_workers * 4)
+		, raw_batches(num_workers * 2) { }
+
+	bool stopped() const {
+		return stop;
+	}
+
+	// Players missing from best_runs were added after it was read, so they're kept
+	bool is_best_run(int data_id, std::string_view pid, int time) const {
+		auto level = options.best_runs->find(data_id);
+		if(level == options.best_runs->end()) {
+			return true;
+		}
+		auto best = level->second.find(pid);
+		return best == level->second.end() || best->second == time;
+	}
+
+	// Blocks until range is close enough to the merge that reading it won't pile up decoded batches
+	void wait_for_range(uint32_t range, uint32_t max_ranges_ahead) {
+		std::unique_lock<std::mutex> lock(decoded_mutex);
+		merge_progress.wait(lock, [&] { return stop || range < merge_range + max_ranges_ahead; });
+	}
+
+	// Steps stmt until done, pushing its rows as batches of range. Returns false if SQLite failed
+	bool read_range(sqlite3_stmt* stmt, uint32_t range) {
+		bool ok = true;
+		RawBatch batch;
+		batch.range = range;
+
+		while(!stop) {
+			int step = sqlite3_step(stmt);
+			if(step == SQLITE_ROW) {
+				int data_id          = sqlite3_column_int(stmt, 0);
+				std::string_view pid = column_string_view(stmt, 1);
+				int time             = sqlite3_column_int(stmt, 2);
+
+				// Looked up in SQLite's row buffer, a skipped row never copies its pid
+				if(options.best_runs && !is_best_run(data_id, pid, time)) {
+					superseded++;
+					continue;
+				}
+
+				RawReplay row;
+				row.data_id = data_id;
+				row.pid     = std::string(pid);
+				row.time    = time;
+
+				if(options.stream_replays) {
+					row.rowid = sqlite3_column_int64(stmt, 3);
+				} else {
+					const uint8_t* replay_data = (const uint8_t*)sqlite3_column_blob(stmt, 3);
+					int replay_size            = sqlite3_column_bytes(stmt, 3);
+					row.replay.assign(replay_data, replay_data + replay_size);
+					bytes_read += replay_size;
+				}
+
+				uint64_t row_count = ++rows;
+				if(row_count % 1000 == 0) {
+					std::cout << "Handled ninji row " << row_count << std::endl;
+				}
+
+				batch.rows.push_back(std::move(row));
+				if(batch.rows.size() == INGEST_BATCH_SIZE) {
+					push_batch(batch);
+				}
+			} else if(step == SQLITE_DONE) {
+				break;
+			} else if(step == SQLITE_BUSY) {
+				// Ignore
+			} else {
+				std::cout << "Sqlite could not step replay query: " << sqlite3_errstr(step) << std::endl;
+				ok = false;
+				break;
+			}
+		}
+
+		if(!batch.rows.empty()) {
+			push_batch(batch);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(decoded_mutex);
+			range_batches[range] = batch.index;
+		}
+		decoded_ready.notify_all();
+
+		return ok;
+	}
+
+	// Called once every reader is done
+	void close() {
+		raw_batches.close();
+	}
+
+	// Runs the workers and merges on the calling thread until every pushed batch has been released
+	void run(const std::function<bool(IngestedReplay&)>& on_replay) {
+		std::vector<std::thread> workers;
+		for(int i = 0; i < num_workers; i++) {
+			workers.emplace_back([&] { work(); });
+		}
+
+		// Merge stage, batches are released strictly in read order
+		while(true) {
+			std::vector<IngestedReplay> replays;
+			{
+				std::unique_lock<std::mutex> lock(decoded_mutex);
+				decoded_ready.wait(lock, [&] {
+					return decoded.count(batch_key(merge_range, merge_batch)) || range_finished()
+						   || workers_running == 0;
+				});
+				auto it = decoded.find(batch_key(merge_range, merge_batch));
+				if(it != decoded.end()) {
+					replays = std::move(it->second);
+					decoded.erase(it);
+					merge_batch++;
+					in_flight--;
+				} else if(range_finished()) {
+					range_batches.erase(merge_range);
+					merge_range++;
+					merge_batch = 0;
+				} else {
+					break;
+				}
+			}
+			merge_progress.notify_all();
+
+			for(auto& replay : replays) {
+				if(stop) {
+					break;
+				}
+				if(!on_replay(replay)) {
+					stop = true;
+					merge_progress.notify_all();
+				}
+			}
+		}
+
+		for(auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void add_stats(IngestStats& stats) {
+		stats.rows += rows;
+		stats.bytes_read += bytes_read;
+		stats.bytes_inflated += bytes_inflated;
+		stats.frames += frames;
+		stats.failed += failed;
+		stats.superseded += superseded;
+		stats.guessed += guessed;
+		for(size_t i = 0; i < NINJI_DECODE_ERROR_COUNT; i++) {
+			stats.malformed[i] += malformed[i];
+		}
+	}
+
+private:
+	// Needs decoded_mutex
+	bool range_finished() {
+		auto it = range_batches.find(merge_range);
+		return it != range_batches.end() && it->second == merge_batch;
+	}
+
+	void push_batch(RawBatch& batch) {
+		{
+			// The range being merged only has to stay within its own window, so it can always make progress however
+			// far ahead the other ranges are
+			std::unique_lock<std::mutex> lock(decoded_mutex);
+			merge_progress.wait(lock, [&] {
+				return stop
+					   || (batch.range == merge_range ? batch.index < merge_batch + max_in_flight
+													  : in_flight < max_in_flight);
+			});
+			in_flight++;
+		}
+
+		uint32_t range = batch.range;
+		uint32_t index = batch.index;
+		raw_batches.push(std::move(batch));
+		batch       = RawBatch {};
+		batch.range = range;
+		batch.index = index + 1;
+	}
+
+	void count_failure(const NinjiDecodeStatus& status) {
+		if(status.error == NinjiDecodeError::NONE) {
+			failed++;
+		} else {
+			malformed[(size_t)status.error]++;
+		}
+	}
+
+	void work() {
+		// Blob handles belong to a connection, so streaming workers each get their own
+		sqlite3* worker_db = nullptr;
+		sqlite3_blob* blob = nullptr;
+		bool worker_db_ok  = true;
+		if(options.stream_replays) {
+			DatabaseOptions worker_options = options.database;
+			worker_options.read_only       = true;
+			worker_options.single_thread   = true;
+			worker_db_ok                   = open_database(options.db_path, worker_options, &worker_db);
+		}
+
+		RawBatch batch;
+		std::span<const uint8_t> decompressed_replay;
+		while(raw_batches.pop(batch)) {
+			std::vector<IngestedReplay> replays;
+			replays.reserve(batch.rows.size());
+
+			for(auto& row : batch.rows) {
+				IngestedReplay replay { row.data_id, std::move(row.pid), row.time, 0, {} };
+
+				// Dumped replays are needed whole, so they skip streaming and are read in one go
+				bool dump_replay = options.dump && options.dump->wants(replay.pid);
+
+				int rc = SQLITE_OK;
+				if(options.stream_replays) {
+					rc = SQLITE_ERROR;
+					if(worker_db_ok) {
+						// Reopening an existing handle skips the table and column lookup
+						rc = blob ? sqlite3_blob_reopen(blob, row.rowid)
+								  : sqlite3_blob_open(worker_db, "main", "ninji", "replay", row.rowid, 0, &blob);
+					}
+					if(rc == SQLITE_OK && dump_replay) {
+						row.replay.resize(sqlite3_blob_bytes(blob));
+						rc = sqlite3_blob_read(blob, row.replay.data(), row.replay.size(), 0);
+					}
+					if(rc != SQLITE_OK) {
+						failed++;
+						continue;
+					}
+					bytes_read += sqlite3_blob_bytes(blob);
+				}
+
+				NinjiDecodeStatus status;
+				if(options.stream_replays && !dump_replay) {
+					size_t inflated_size = 0;
+					if(!stream_ninji_replay(blob, replay.charactor, replay.frames, inflated_size, status)) {
+						count_failure(status);
+						continue;
+					}
+					bytes_inflated += inflated_size;
+				} else {
+					if(!gzip_decompress(row.replay.data(), row.replay.size(), decompressed_replay)) {
+						failed++;
+						continue;
+					}
+					bytes_inflated += decompressed_replay.size();
+
+					// Dumped before decoding so replays the decoder rejects can still be looked at
+					if(dump_replay) {
+						options.dump->add(replay.data_id, replay.pid, decompressed_replay);
+					}
+
+					if(!decode_ninji_replay(decompressed_replay, replay.charactor, replay.frames, status)) {
+						count_failure(status);
+						continue;
+					}
+				}
+
+				if(status.guessed_frames) {
+					guessed++;
+				}
+
+				frames += replay.frames.size();
+				replays.push_back(std::move(replay));
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(decoded_mutex);
+				decoded[batch_key(batch.range, batch.index)] = std::move(replays);
+			}
+			decoded_ready.notify_all();
+		}
+
+		if(blob) {
+			sqlite3_blob_close(blob);
+		}
+		if(worker_db) {
+			sqlite3_close(worker_db);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(decoded_mutex);
+			workers_running--;
+		}
+		decoded_ready.notify_all();
+	}
+
+	const IngestOptions& options;
+	const int num_workers;
+	// Batches read but not yet merged, bounds memory when SQLite is faster than inflate
+	const uint64_t max_in_flight;
+
+	WorkQueue<RawBatch> raw_batches;
+
+	// Decoded batches waiting for the merge stage, keyed by range and index
+	std::mutex decoded_mutex;
+	std::condition_variable decoded_ready;
+	std::condition_variable merge_progress;
+	std::map<uint64_t, std::vector<IngestedReplay>> decoded;
+	// Number of batches in every range that has been read completely
+	std::map<uint32_t, uint32_t> range_batches;
+	uint32_t merge_range = 0;
+	uint32_t merge_batch = 0;
+	uint64_t in_flight   = 0;
+	int workers_running  = num_workers;
+
+	std::atomic<bool> stop { false };
+	std::atomic<uint64_t> rows { 0 };
+	std::atomic<uint64_t> bytes_read { 0 };
+	std::atomic<uint64_t> bytes_inflated { 0 };
+	std::atomic<uint64_t> frames { 0 };
+	std::atomic<uint64_t> failed { 0 };
+	std::atomic<uint64_t> superseded { 0 };
+	std::atomic<uint64_t> guessed { 0 };
+	std::atomic<uint64_t> malformed[NINJI_DECODE_ERROR_COUNT] {};
+};
+
+bool ingest_replays(sqlite3_stmt* stmt, const IngestOptions& options,
+	const std::function<bool(IngestedReplay&)>& on_replay, IngestStats& stats) {
+	auto start = std::chrono::steady_clock::now();
+
+	IngestPipeline pipeline(options);
+
+	bool read_ok = true;
+	std::thread reader([&] {
+		read_ok = pipeline.read_range(stmt, 0);
+		pipeline.close();
+	});
+
+	pipeline.run(on_replay);
+	reader.join();
+
+	pipeline.add_stats(stats);
+	stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return read_ok;
+}
+
+bool ingest_replays_sharded(sqlite3* db, const std::string& query, const std::vector<int>& params,
+	const IngestOptions& options, const std::function<bool(IngestedReplay&)>& on_replay, IngestStats& stats) {
+	auto start = std::chrono::steady_clock::now();
+
+	sqlite3_int64 min_rowid = 0;
+	sqlite3_int64 max_rowid = -1;
+	sqlite3_stmt* res;
+	if(sqlite3_prepare_v2(db, "SELECT MIN(rowid),MAX(rowid) FROM ninji", -1, &res, 0) != SQLITE_OK) {
+		std::cout << "Sqlite could not prepare rowid query: " << sqlite3_errmsg(db) << std::endl;
+		return false;
+	}
+	if(sqlite3_step(res) == SQLITE_ROW && sqlite3_column_type(res, 0) != SQLITE_NULL) {
+		min_rowid = sqlite3_column_int64(res, 0);
+		max_rowid = sqlite3_column_int64(res, 1);
+	}
+	sqlite3_finalize(res);
+
+	int num_shards = std::max(options.num_shards, 1);
+
+	// Ranges only depend on the table and shard count, so the merge order is the same every run
+	uint64_t span       = max_rowid - min_rowid + 1;
+	uint32_t num_ranges = std::max<uint64_t>(std::min<uint64_t>(num_shards * INGEST_RANGES_PER_SHARD, span), 1);
+	uint64_t range_size = (span + num_ranges - 1) / num_ranges;
+
+	std::string shard_query = query + " AND rowid BETWEEN ? AND ? ORDER BY rowid";
+
+	IngestPipeline pipeline(options);
+
+	std::atomic<uint32_t> next_range { 0 };
+	std::atomic<int> shards_running { num_shards };
+	std::atomic<bool> read_ok { true };
+
+	std::vector<std::thread> shards;
+	for(int i = 0; i < num_shards; i++) {
+		shards.emplace_back([&] {
+			DatabaseOptions shard_options = options.database;
+			shard_options.read_only       = true;
+			shard_options.single_thread   = true;
+
+			sqlite3* shard_db  = nullptr;
+			sqlite3_stmt* stmt = nullptr;
+			if(!open_database(options.db_path, shard_options, &shard_db)) {
+				read_ok = false;
+			} else if(sqlite3_prepare_v2(shard_db, shard_query.c_str(), -1, &stmt, 0) != SQLITE_OK) {
+				std::cout << "Sqlite could not prepare shard query: " << sqlite3_errmsg(shard_db) << std::endl;
+				read_ok = false;
+			} else {
+				for(size_t p = 0; p < params.size(); p++) {
+					sqlite3_bind_int(stmt, p + 1, params[p]);
+				}
+
+				while(!pipeline.stopped()) {
+					uint32_t range = next_range++;
+					if(range >= num_ranges) {
+						break;
+					}
+
+					pipeline.wait_for_range(range, num_shards * 2);
+
+					sqlite3_int64 first = min_rowid + range * range_size;
+					sqlite3_bind_int64(stmt, params.size() + 1, first);
+					sqlite3_bind_int64(stmt, params.size() + 2, first + range_size - 1);
+					if(!pipeline.read_range(stmt, range)) {
+						read_ok = false;
+					}
+					sqlite3_reset(stmt);
+				}
+			}
+
+			sqlite3_finalize(stmt);
+			sqlite3_close(shard_db);
+
+			if(--shards_running == 0) {
+				pipeline.close();
+			}
+		});
+	}
+
+	pipeline.run(on_replay);
+	for(auto& shard : shards) {
+		shard.join();
+	}
+
+	pipeline.add_stats(stats);
+	stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return read_ok;
+}
+
+// Creates or empties temp.selected_ninji and prepares the insert selections fill it with
+static bool prepare_selection(sqlite3* db, sqlite3_stmt** times, sqlite3_stmt** insert) {
+	char* err_msg = nullptr;
+	if(sqlite3_exec(db,
+		   "CREATE TEMP TABLE IF NOT EXISTS selected_ninji(rowid INTEGER PRIMARY KEY);"
+		   "DELETE FROM temp.selected_ninji;",
+		   NULL, NULL, &err_msg)
+		!= SQLITE_OK) {
+		std::cout << "Sqlite could not create selected replay table: " << err_msg << std::endl;
+		sqlite3_free(err_msg);
+		return false;
+	}
+
+	// Only each player's best run is a candidate, SQLite takes the bare rowid from the row holding MIN(time)
+	if(sqlite3_prepare_v2(db, "SELECT rowid,MIN(time) FROM ninji WHERE data_id = ? GROUP BY pid", -1, times, 0)
+		!= SQLITE_OK) {
+		std::cout << "Sqlite could not prepare time query: " << sqlite3_errmsg(db) << std::endl;
+		return false;
+	}
+
+	if(sqlite3_prepare_v2(db, "INSERT INTO temp.selected_ninji(rowid) VALUES (?)", -1, insert, 0) != SQLITE_OK) {
+		std::cout << "Sqlite could not prepare selected replay insert: " << sqlite3_errmsg(db) << std::endl;
+		sqlite3_finalize(*times);
+		return false;
+	}
+
+	return sqlite3_exec(db, "BEGIN", NULL, NULL, NULL) == SQLITE_OK;
+}
+
+static bool insert_selected(sqlite3* db, sqlite3_stmt* insert, sqlite3_int64 rowid) {
+	sqlite3_bind_int64(insert, 1, rowid);
+	if(sqlite3_step(insert) != SQLITE_DONE) {
+		std::cout << "Sqlite could not insert selected replay: " << sqlite3_errmsg(db) << std::endl;
+		sqlite3_reset(insert);
+		return false;
+	}
+	sqlite3_reset(insert);
+	return true;
+}
+
+static bool finish_selection(sqlite3* db, sqlite3_stmt* times, sqlite3_stmt* insert, bool ok) {
+	sqlite3_exec(db, ok ? "COMMIT" : "ROLLBACK", NULL, NULL, NULL);
+	sqlite3_finalize(times);
+	sqlite3_finalize(insert);
+	return ok;
+}
+
+// Steps a prepared time query for one level, calling on_row with (time, rowid) of every row
+static bool read_level_times(sqlite3_stmt* times, int data_id, const std::function<void(int, sqlite3_int64)>& on_row) {
+	sqlite3_bind_int(times, 1, data_id);
+	int step;
+	while((step = sqlite3_step(times)) == SQLITE_ROW) {
+		on_row(sqlite3_column_int(times, 1), sqlite3_column_int64(times, 0));
+	}
+	sqlite3_reset(times);
+	if(step != SQLITE_DONE) {
+		std::cout << "Sqlite could not step time query: " << sqlite3_errstr(step) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool find_best_runs(sqlite3* db, const std::vector<int>& levels, BestRuns& best_runs) {
+	sqlite3_stmt* res;
+	if(sqlite3_prepare_v2(db, "SELECT pid,MIN(time) FROM ninji WHERE data_id = ? GROUP BY pid", -1, &res, 0)
+		!= SQLITE_OK) {
+		std::cout << "Sqlite could not prepare best run query: " << sqlite3_errmsg(db) << std::endl;
+		return false;
+	}
+
+	bool ok = true;
+	for(size_t i = 0; ok && i < levels.size(); i++) {
+		auto& level_best = best_runs[levels[i]];
+		sqlite3_bind_int(res, 1, levels[i]);
+		int step;
+		while((step = sqlite3_step(res)) == SQLITE_ROW) {
+			level_best[(const char*)sqlite3_column_text(res, 0)] = sqlite3_column_int(res, 1);
+		}
+		sqlite3_reset(res);
+		if(step != SQLITE_DONE) {
+			std::cout << "Sqlite could not step best run query: " << sqlite3_errstr(step) << std::endl;
+			ok = false;
+		}
+	}
+
+	sqlite3_finalize(res);
+	return ok;
+}
+
+bool select_top_replays(sqlite3* db, const std::vector<int>& levels, int n,
+	std::unordered_map<int, uint64_t>& players_considered) {
+	sqlite3_stmt* times;
+	sqlite3_stmt* insert;
+	if(!prepare_selection(db, &times, &insert)) {
+		return false;
+	}
+
+	bool ok = true;
+	for(size_t i = 0; ok && i < levels.size(); i++) {
+		// Max heap of the n fastest so far, the slowest of them is dropped first. Ties go to the lower rowid so the
+		// selection is the same every run
+		std::priority_queue<std::pair<int, sqlite3_int64>> fastest;
+		// One result row per player, the query already grouped away their slower runs
+		auto& considered = players_considered[levels[i]];
+		ok               = read_level_times(times, levels[i], [&](int time, sqlite3_int64 rowid) {
+			considered++;
+			fastest.emplace(time, rowid);
+			if(fastest.size() > (size_t)n) {
+				fastest.pop();
+			}
+		});
+
+		for(; ok && !fastest.empty(); fastest.pop()) {
+			ok = insert_selected(db, insert, fastest.top().second);
+		}
+	}
+
+	return finish_selection(db, times, insert, ok);
+}
+
+bool select_sampled_replays(sqlite3* db, const std::vector<int>& levels, int n, int strata, uint64_t seed,
+	std::unordered_map<int, std::vector<int>>& population_times) {
+	sqlite3_stmt* times;
+	sqlite3_stmt* insert;
+	if(!prepare_selection(db, &times, &insert)) {
+		return false;
+	}
+
+	strata = std::max(strata, 1);
+
+	bool ok = true;
+	std::vector<std::pair<int, sqlite3_int64>> rows;
+	for(size_t i = 0; ok && i < levels.size(); i++) {
+		int data_id = levels[i];
+		rows.clear();
+		ok = read_level_times(times, data_id, [&](int time, sqlite3_int64 rowid) { rows.emplace_back(time, rowid); });
+		if(!ok) {
+			break;
+		}
+
+		// Sorted by time then rowid, stratum s is the s-th slice of equal size, so buckets follow time percentiles
+		std::sort(rows.begin(), rows.end());
+		auto& level_population = population_times[data_id];
+		level_population.clear();
+		for(auto& row : rows) {
+			level_population.push_back(row.first);
+		}
+
+		// Seeded per level so a level samples the same rows whatever else is rendered with it
+		std::mt19937_64 rng(seed ^ ((uint64_t)data_id * 0x9E3779B97F4A7C15));
+		size_t num_rows = rows.size();
+		for(int stratum = 0; ok && stratum < strata; stratum++) {
+			size_t begin = num_rows * stratum / strata;
+			size_t end   = num_rows * (stratum + 1) / strata;
+			size_t quota = (size_t)n * (stratum + 1) / strata - (size_t)n * stratum / strata;
+			quota        = std::min(quota, end - begin);
+
+			// Partial Fisher-Yates, the first quota rows of the stratum end up a uniform sample of it
+			for(size_t j = 0; ok && j < quota; j++) {
+				size_t pick = begin + j + rng() % (end - begin - j);
+				std::swap(rows[begin + j], rows[pick]);
+				ok = insert_selected(db, insert, rows[begin + j].second);
+			}
+		}
+	}
+
+	return finish_selection(db, times, insert, ok);
+}
+
+void print_ingest_stats(const IngestStats& stats) {
+	std::cout << "Ingested " << stats.rows << " rows (" << stats.bytes_read / 1000000.0 << " MB of replays, "
+			  << stats.bytes_inflated / 1000000.0 << " MB inflated, " << stats.frames << " frames) in " << stats.seconds
+			  << "s, " << stats.rows / stats.seconds << " rows/s, " << stats.bytes_read / 1000000.0 / stats.seconds
+			  << " MB/s" << std::endl;
+	if(stats.failed) {
+		std::cout << "Could not decode " << stats.failed << " replays" << std::endl;
+	}
+	if(stats.superseded) {
+		std::cout << "Skipped " << stats.superseded << " runs slower than their player's best" << std::endl;
+	}
+	print_decode_problems(stats);
+}
+
+void print_decode_problems(const IngestStats& stats) {
+	uint64_t malformed = 0;
+	for(auto count : stats.malformed) {
+		malformed += count;
+	}
+	if(malformed) {
+		std::cout << "Skipped " << malformed << " malformed replays:";
+		const char* separator = " ";
+		for(size_t i = 1; i < NINJI_DECODE_ERROR_COUNT; i++) {
+			if(stats.malformed[i]) {
+				std::cout << separator << stats.malformed[i] << " " << ninji_decode_error_name((NinjiDecodeError)i);
+				separator = ", ";
+			}
+		}
+		std::cout << std::endl;
+	}
+	if(stats.guessed) {
+		std::cout << stats.guessed << " replays have frames in an undocumented layout and may decode wrong"
+				  << std::endl;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "database.hpp"
+#include "replay.hpp"
+#include "replay_dump.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct IngestedReplay {
+	int data_id;
+	std::string pid;
+	int time;
+	uint8_t charactor;
+	std::vector<NinjiFrame> frames;
+};
+
+// Lets best runs be found by a pid that hasn't been copied out of its row yet
+struct PidHash {
+	using is_transparent = void;
+	size_t operator()(std::string_view pid) const {
+		return std::hash<std::string_view>()(pid);
+	}
+};
+
+// Best time of every player of a level, by data_id then pid
+using BestRuns = std::unordered_map<int, std::unordered_map<std::string, int, PidHash, std::equal_to<>>>;
+
+struct IngestOptions {
+	int num_workers = 1;
+	// Workers stream replays out of the database with sqlite3_blob_read instead of the reader copying whole blobs,
+	// stmt then selects the rowid in place of the replay and every worker opens db_path itself
+	bool stream_replays = false;
+	std::string db_path;
+	DatabaseOptions database;
+	// Read only connections ingest_replays_sharded scans rowid ranges on
+	int num_shards = 1;
+	// Decompressed replays of the pids selected in dump are copied into it, null to dump nothing
+	ReplayDump* dump = nullptr;
+	// Rows slower than their player's best run are skipped before their replay is read, null to keep every row
+	const BestRuns* best_runs = nullptr;
+};
+
+struct IngestStats {
+	uint64_t rows           = 0;
+	uint64_t bytes_read     = 0;
+	uint64_t bytes_inflated = 0;
+	uint64_t frames         = 0;
+	uint64_t failed         = 0;
+	uint64_t superseded     = 0;
+	// Replays the decoder rejected, by NinjiDecodeError
+	uint64_t malformed[NINJI_DECODE_ERROR_COUNT] = {};
+	// Replays kept that have frames in a guessed layout
+	uint64_t guessed = 0;
+	double seconds   = 0;
+};
+
+// Steps stmt, which must select (data_id, pid, time, replay), on a reader thread and inflates and decodes the replays on
+// worker threads. on_replay is called on the calling thread in the exact order the rows were read, so the result
+// doesn't depend on the number of workers. Returning false from on_replay stops the ingest early
+bool ingest_replays(sqlite3_stmt* stmt, const IngestOptions& options,
+	const std::function<bool(IngestedReplay&)>& on_replay, IngestStats& stats);
+
+// Splits ninji into rowid ranges and scans them on options.num_shards connections to db_path at once. query must select
+// (data_id, pid, time, replay) and end in a WHERE clause taking params, the rowid range and ordering are appended.
+// Ranges are released in rowid order, so like ingest_replays the order replays arrive in is stable run to run
+bool ingest_replays_sharded(sqlite3* db, const std::string& query, const std::vector<int>& params,
+	const IngestOptions& options, const std::function<bool(IngestedReplay&)>& on_replay, IngestStats& stats);
+
+// Reads the best time of every player of levels with a GROUP BY, no replay is touched. Only cheap with the
+// (data_id, time, pid) index to answer it from, otherwise it scans the table once more per level
+bool find_best_runs(sqlite3* db, const std::vector<int>& levels, BestRuns& best_runs);
+
+// First half of a top N ingest, reads only the rowid and time of every player's best run in levels and leaves the
+// rowids of the n fastest per level in temp.selected_ninji. The replay query then only fetches those blobs by joining on it. The
+// table lives on db, so the replays have to be read on that connection rather than sharded. The number of players each
+// level's selection was made from is returned by data_id
+bool select_top_replays(sqlite3* db, const std::vector<int>& levels, int n,
+	std::unordered_map<int, uint64_t>& players_considered);
+
+// Like select_top_replays, but splits each level into strata time percentile buckets and picks a seeded uniform
+// sample of n / strata runs from each. The best times of every player are returned sorted per level, so ranks can
+// still be given against the whole population
+bool select_sampled_replays(sqlite3* db, const std::vector<int>& levels, int n, int strata, uint64_t seed,
+	std::unordered_map<int, std::vector<int>>& population_times);
+
+void print_ingest_stats(const IngestStats& stats);
+
+// Malformed replays by cause and replays decoded with guessed frame sizes, nothing if there were none
+void print_decode_problems(const IngestStats& stats);
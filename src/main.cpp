@@ -12,11 +12,14 @@
 #include <chrono>
 #include <codec/SkCodec.h>
 #include <core/SkBitmap.h>
+#include <core/SkBBHFactory.h>
 #include <core/SkCanvas.h>
 #include <core/SkColor.h>
 #include <core/SkFont.h>
 #include <core/SkGraphics.h>
 #include <core/SkImage.h>
+#include <core/SkPicture.h>
+#include <core/SkPictureRecorder.h>
 #include <core/SkStream.h>
 #include <core/SkSurface.h>
 #include <core/SkTextBlob.h>
@@ -30,7 +33,9 @@
 #include <gpu/GrDirectContext.h>
 #include <gpu/gl/GrGLInterface.h>
 #include <iostream>
+#include <span>
 #include <sqlite3.h>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utils/SkRandom.h>
@@ -61,6 +66,21 @@ extern "C" {
 
 #undef min
 #undef max
+#include "band_renderer.hpp"
+#include "compressed_path.hpp"
+#include "country.hpp"
+#include "damage_tracker.hpp"
+#include "database.hpp"
+#include "frame_store.hpp"
+#include "ingest.hpp"
+#include "path_trie.hpp"
+#include "player_registry.hpp"
+#include "replay.hpp"
+#include "replay_cache.hpp"
+#include "sprite_atlas.hpp"
+#include "sprite_cache.hpp"
+#include "string_arena.hpp"
+#include "time_major.hpp"
 #include "spline.h"
 
 #define RENDER_VIDEO 1
@@ -79,85 +99,20 @@ extern "C" {
 #define NUM_SUBFRAMES 8
 #define SIZE_MULTIPLIER 2
 
-bool gzip_decompress(uint8_t* input, int input_size, std::vector<uint8_t>& output) {
-	output.clear();
-
-	unsigned full_length = input_size;
-	unsigned half_length = input_size / 2;
-
-	unsigned uncompLength = full_length;
-	char* uncomp          = (char*)calloc(sizeof(char), uncompLength);
-
-	z_stream strm;
-	strm.next_in   = input;
-	strm.avail_in  = input_size;
-	strm.total_out = 0;
-	strm.zalloc    = Z_NULL;
-	strm.zfree     = Z_NULL;
-
-	bool done = false;
-
-	if(inflateInit2(&strm, (32 + MAX_WBITS)) != Z_OK) {
-		free(uncomp);
-		return false;
-	}
-
-	while(!done) {
-		// If our output buffer is too small
-		if(strm.total_out >= uncompLength) {
-			// Increase size of output buffer
-			char* uncomp2 = (char*)calloc(sizeof(char), uncompLength + half_length);
-			memcpy(uncomp2, uncomp, uncompLength);
-			uncompLength += half_length;
-			free(uncomp);
-			uncomp = uncomp2;
-		}
-
-		strm.next_out  = (Bytef*)(uncomp + strm.total_out);
-		strm.avail_out = uncompLength - strm.total_out;
-
-		// Inflate another chunk.
-		int err = inflate(&strm, Z_SYNC_FLUSH);
-		if(err == Z_STREAM_END)
-			done = true;
-		else if(err != Z_OK) {
-			break;
-		}
-	}
-
-	if(inflateEnd(&strm) != Z_OK) {
-		free(uncomp);
-		return false;
-	}
-
-	std::copy(uncomp, uncomp + strm.total_out, std::back_inserter(output));
-
-	free(uncomp);
-	return true;
-}
-
-void toLittleEndian(uint32_t& ui) {
-	ui = (ui >> 24) | ((ui << 8) & 0x00FF0000) | ((ui >> 8) & 0x0000FF00) | (ui << 24);
-}
-
-void toLittleEndianShort(uint16_t& ui) {
-	ui = (ui >> 8) | (ui << 8);
-}
-
 static size_t write_cb(char* data, size_t n, size_t l, void* userp) {
 	((std::string*)userp)->append(data, n * l);
 	return n * l;
 }
 
 void downloadMiis(std::vector<std::string>& miis_to_download, std::vector<int>& miis_to_download_player,
-	std::unordered_map<int, std::string>& mii_images, std::unordered_map<int, std::string>& player_to_pid) {
+	std::unordered_map<int, std::string>& mii_images, const PlayerRegistry& players) {
 	// First handle cached
 	auto it  = miis_to_download_player.begin();
 	auto it2 = miis_to_download.begin();
 	while(it != miis_to_download_player.end()) {
-		if(std::filesystem::exists(std::string("../mii_cache/") + player_to_pid[*it] + ".png")) {
+		if(std::filesystem::exists(std::string("../mii_cache/") + std::string(players.pid(*it)) + ".png")) {
 			std::ifstream mii_image(
-				std::string("../mii_cache/") + player_to_pid[*it] + ".png", std::ios::in | std::ios::binary);
+				std::string("../mii_cache/") + std::string(players.pid(*it)) + ".png", std::ios::in | std::ios::binary);
 			std::string data((std::istreambuf_iterator<char>(mii_image)), std::istreambuf_iterator<char>());
 			mii_image.close();
 			mii_images[*it] = data;
@@ -237,9 +192,9 @@ void downloadMiis(std::vector<std::string>& miis_to_download, std::vector<int>&
 		} while(readRequests < NUM_URLS);
 
 		for(auto& image : mii_images) {
-			if(!std::filesystem::exists(std::string("../mii_cache/") + player_to_pid[image.first] + ".png")) {
+			if(!std::filesystem::exists(std::string("../mii_cache/") + std::string(players.pid(image.first)) + ".png")) {
 				std::filesystem::create_directory("../mii_cache");
-				auto cached_mii_image = std::fstream(std::string("../mii_cache/") + player_to_pid[image.first] + ".png",
+				auto cached_mii_image = std::fstream(std::string("../mii_cache/") + std::string(players.pid(image.first)) + ".png",
 					std::ios::out | std::ios::binary);
 				cached_mii_image.write(image.second.c_str(), image.second.size());
 				cached_mii_image.close();
@@ -364,8 +319,120 @@ int main(int argc, char* argv[]) {
 	std::unordered_set<int> levels_to_render;
 	app.add_option("--ids", levels_to_render, "Level IDs to include");
 
+	bool create_index = false;
+	app.add_flag("--create-index", create_index, "Build a covering index on ninji(data_id, time, pid) before ingest");
+
+	int ingest_threads = std::thread::hardware_concurrency();
+	app.add_option("--ingest-threads", ingest_threads, "Worker threads used to inflate and decode replays");
+
+	bool use_replay_cache = true;
+	app.add_flag("--replay-cache,!--no-replay-cache", use_replay_cache, "Load preprocessed replays per level instead of decoding them again");
+
+	std::string replay_cache_dir = "../replay_cache";
+	app.add_option("--replay-cache-dir", replay_cache_dir, "Directory holding preprocessed replays per level");
+
+	bool stream_replays = false;
+	app.add_flag("--stream-replays", stream_replays,
+		"Inflate and decode replays straight out of the database in fixed size windows, bounding memory per replay");
+
+	std::vector<std::string> dump_pids;
+	app.add_option("--dump-replay", dump_pids, "Write the decompressed replays of these pids to the dump file");
+
+	std::string dump_path = "replay_dump.bin";
+	app.add_option("--dump-file", dump_path, "Archive written by --dump-replay");
+
+	std::string db_path = "../ninji_replay.db";
+	app.add_option("--db", db_path, "Replay database");
+
+	DatabaseOptions database_options;
+	app.add_flag("--immutable", database_options.immutable,
+		"Open the database read only and immutable, memory mapped with no locking");
+	app.add_option("--db-cache-mb", database_options.cache_size_mb, "SQLite page cache per connection in MB");
+
+	int scan_shards = 1;
+	app.add_option("--scan-shards", scan_shards,
+		"Split the ninji table into rowid ranges and scan them on this many read only connections");
+
+	bool prefetch_db = false;
+	app.add_flag("--prefetch-db", prefetch_db, "Page the database in on a background thread while ingesting");
+
+	bool use_time_major = false;
+	app.add_flag("--time-major", use_time_major,
+		"Transpose each level's frames so every rendered frame reads the positions of all ghosts contiguously");
+
+	bool map_time_major = false;
+	app.add_flag("--time-major-mmap", map_time_major,
+		"Write the transposed frames to --time-major-dir and map them instead of keeping them in memory");
+
+	std::string time_major_dir = "../time_major";
+	app.add_option("--time-major-dir", time_major_dir, "Directory --time-major-mmap writes its tables to");
+
+	bool compress_paths = false;
+	app.add_flag("--compress-paths", compress_paths,
+		"Keep paths delta encoded in memory and decode them frame by frame while rendering");
+
+	int top_replays = 0;
+	app.add_option("--top", top_replays,
+		"Only render the N fastest replays of each level, reading every time first and then only their replays");
+
+	int sample_replays = 0;
+	app.add_option("--sample", sample_replays,
+		"Render a reproducible sample of N replays per level, spread evenly over time percentiles");
+
+	int sample_strata = 10;
+	app.add_option("--strata", sample_strata, "Time percentile buckets --sample picks from");
+
+	uint64_t sample_seed = 1;
+	app.add_option("--sample-seed", sample_seed, "Seed of --sample, the same seed picks the same replays");
+
+	bool share_prefixes = false;
+	app.add_flag("--share-prefixes", share_prefixes,
+		"Store identical path openings once and draw ghosts still on them as one sprite with a count");
+
+	bool dirty_rects = false;
+	app.add_flag("--dirty-rects", dirty_rects,
+		"Only restore and redraw the parts of each video frame that changed since the previous one");
+
+	bool show_damage = false;
+	app.add_flag("--show-damage", show_damage,
+		"Outline the tiles restored from the static layer in blue and the ones drawn over in red, implies --dirty-rects");
+
+	int render_threads = 1;
+	app.add_option("--render-threads", render_threads,
+		"Horizontal bands each video frame is rasterized in, each on its own thread");
+
+	int band_scaling_frame = -1;
+	app.add_option("--band-scaling", band_scaling_frame,
+		"Time this frame of each level rendered in 1 up to --render-threads bands and check each matches the serial render");
+
 	CLI11_PARSE(app, argc, argv);
 
+	if(show_damage) {
+		dirty_rects = true;
+	}
+
+	render_threads = std::max(render_threads, 1);
+
+	if(levels_to_render.empty()) {
+		std::cout << "No level IDs passed with --ids" << std::endl;
+		return 1;
+	}
+
+	if(top_replays > 0 && sample_replays > 0) {
+		std::cout << "--top and --sample can't be combined" << std::endl;
+		return 1;
+	}
+
+	// Levels ingested with --top or --sample are missing most of their replays and must not replace a full cache
+	if(top_replays > 0 || sample_replays > 0) {
+		use_replay_cache = false;
+	}
+
+	if(share_prefixes && (compress_paths || use_time_major || map_time_major)) {
+		std::cout << "--share-prefixes can't be combined with --compress-paths or --time-major" << std::endl;
+		return 1;
+	}
+
 	for(auto id : levels_to_render) {
 		std::cout << "Rendering " << id << std::endl;
 	}
@@ -375,15 +442,22 @@ int main(int argc, char* argv[]) {
 	char* err_msg = 0;
 	sqlite3_stmt* res;
 
-	// Open file db
-	int rc = sqlite3_open("../ninji_replay.db", &db);
+	if(create_index && database_options.immutable) {
+		std::cout << "--create-index needs a writable database, drop --immutable" << std::endl;
+		return 1;
+	}
 
-	if(rc != SQLITE_OK) {
-		fprintf(stderr, "Cannot open file database: %s\n", sqlite3_errmsg(file_db));
-		sqlite3_close(file_db);
+	// Open file db
+	int rc = SQLITE_OK;
+	if(!open_database(db_path, database_options, &db)) {
 		return 1;
 	}
 
+	DatabasePrefetcher db_prefetcher;
+	if(prefetch_db && !db_prefetcher.start(db_path)) {
+		std::cout << "Could not map " << db_path << " for prefetching" << std::endl;
+	}
+
 	/*
 		// Open memory db
 		rc = sqlite3_open(":memory:", &db);
@@ -425,34 +499,34 @@ int main(int argc, char* argv[]) {
 		}
 		*/
 
-	char* replay_query = "SELECT data_id,pid,time,replay FROM ninji LIMIT -1 OFFSET 1000000";
-	rc                 = sqlite3_prepare_v2(db, replay_query, -1, &res, 0);
-	if(rc != SQLITE_OK) {
-		std::cout << "Sqlite could not prepare query" << std::endl;
-		printf("%s: %s\n", sqlite3_errstr(sqlite3_extended_errcode(db)), sqlite3_errmsg(db));
-		return -1;
+	if(create_index) {
+		// Lets the level filter seek straight to each data_id instead of scanning every row, and covers the
+		// (pid, time) lookups on its own
+		std::cout << "Creating ninji index" << std::endl;
+		rc = sqlite3_exec(db, "CREATE INDEX IF NOT EXISTS ninji_data_id_time_pid ON ninji(data_id, time, pid)", NULL,
+			NULL, &err_msg);
+		if(rc != SQLITE_OK) {
+			std::cout << "Sqlite could not create index: " << err_msg << std::endl;
+			sqlite3_free(err_msg);
+			return -1;
+		}
 	}
 
-	enum NinjiFrameInfo : int8_t {
-		NONE       = -1,
-		DEATH_UNK1 = 10,
-		DOOR       = 11,
-	};
-
-	struct __attribute__((packed, aligned(8))) NinjiFrame {
-		uint8_t state;
-		uint16_t x;
-		uint16_t y;
-		uint8_t flags;
-		// NinjiFrameInfo info = NinjiFrameInfo::NONE;
-		// uint8_t flags       = 0;
-	};
-
-	struct __attribute__((packed, aligned(8))) NinjiInfo {
-		std::string name;
-		std::string code;
-		std::string country;
-		sk_sp<SkImage> mii_image;
+	// Indexed by player id, names and codes point into strings
+	struct NinjiInfo {
+		StringArena strings;
+		std::vector<std::string_view> name;
+		std::vector<std::string_view> code;
+		std::vector<uint16_t> country;
+		std::vector<sk_sp<SkImage>> mii_image;
+
+		void resize(size_t num_players) {
+			name.resize(num_players);
+			code.resize(num_players);
+			// Players missing from user never get a country, so they start out in the flagless unknown bucket
+			country.resize(num_players, COUNTRY_UNKNOWN);
+			mii_image.resize(num_players);
+		}
 	};
 
 	struct __attribute__((packed, aligned(8))) NinjiGlobalInfo {
@@ -524,538 +598,266 @@ int main(int argc, char* argv[]) {
 
 	// 23738173 26746705 27439231 29234075 12171034 12619193 13428950 14328331
 
-	static std::unordered_map<std::string, int> country_flags = {
-		{ "AC", 0 },
-		{ "AD", 1 },
-		{ "AE", 2 },
-		{ "AF", 3 },
-		{ "AG", 4 },
-		{ "AI", 5 },
-		{ "AL", 6 },
-		{ "AM", 7 },
-		{ "AO", 8 },
-		{ "AQ", 9 },
-		{ "AR", 10 },
-		{ "AS", 11 },
-		{ "AT", 12 },
-		{ "AU", 13 },
-		{ "AW", 14 },
-		{ "AX", 15 },
-		{ "AZ", 16 },
-		{ "BA", 17 },
-		{ "BB", 18 },
-		{ "BD", 19 },
-		{ "BE", 20 },
-		{ "BF", 21 },
-		{ "BG", 22 },
-		{ "BH", 23 },
-		{ "BI", 24 },
-		{ "BJ", 25 },
-		{ "BL", 26 },
-		{ "BM", 27 },
-		{ "BN", 28 },
-		{ "BO", 29 },
-		{ "BQ", 30 },
-		{ "BR", 31 },
-		{ "BS", 32 },
-		{ "BT", 33 },
-		{ "BV", 34 },
-		{ "BW", 35 },
-		{ "BY", 36 },
-		{ "BZ", 37 },
-		{ "CA", 38 },
-		{ "CC", 39 },
-		{ "CD", 40 },
-		{ "CF", 41 },
-		{ "CG", 42 },
-		{ "CH", 43 },
-		{ "CI", 44 },
-		{ "CK", 45 },
-		{ "CL", 46 },
-		{ "CM", 47 },
-		{ "CN", 48 },
-		{ "CO", 49 },
-		{ "CP", 50 },
-		{ "CR", 51 },
-		{ "CU", 52 },
-		{ "CV", 53 },
-		{ "CW", 54 },
-		{ "CX", 55 },
-		{ "CY", 56 },
-		{ "CZ", 57 },
-		{ "DE", 58 },
-		{ "DG", 59 },
-		{ "DJ", 60 },
-		{ "DK", 61 },
-		{ "DM", 62 },
-		{ "DO", 63 },
-		{ "DZ", 64 },
-		{ "EA", 65 },
-		{ "EC", 66 },
-		{ "EE", 67 },
-		{ "EG", 68 },
-		{ "EH", 69 },
-		{ "ER", 70 },
-		{ "ES", 71 },
-		{ "ET", 72 },
-		{ "EU", 73 },
-		{ "FI", 74 },
-		{ "FJ", 75 },
-		{ "FK", 76 },
-		{ "FM", 77 },
-		{ "FO", 78 },
-		{ "FR", 79 },
-		{ "GA", 80 },
-		{ "GB", 81 },
-		{ "GD", 82 },
-		{ "GE", 83 },
-		{ "GF", 84 },
-		{ "GG", 85 },
-		{ "GH", 86 },
-		{ "GI", 87 },
-		{ "GL", 88 },
-		{ "GM", 89 },
-		{ "GN", 90 },
-		{ "GP", 91 },
-		{ "GQ", 92 },
-		{ "GR", 93 },
-		{ "GS", 94 },
-		{ "GT", 95 },
-		{ "GU", 96 },
-		{ "GW", 97 },
-		{ "GY", 98 },
-		{ "HK", 99 },
-		{ "HM", 100 },
-		{ "HN", 101 },
-		{ "HR", 102 },
-		{ "HT", 103 },
-		{ "HU", 104 },
-		{ "IC", 105 },
-		{ "ID", 106 },
-		{ "IE", 107 },
-		{ "IL", 108 },
-		{ "IM", 109 },
-		{ "IN", 110 },
-		{ "IO", 111 },
-		{ "IQ", 112 },
-		{ "IR", 113 },
-		{ "IS", 114 },
-		{ "IT", 115 },
-		{ "JE", 116 },
-		{ "JM", 117 },
-		{ "JO", 118 },
-		{ "JP", 119 },
-		{ "KE", 120 },
-		{ "KG", 121 },
-		{ "KH", 122 },
-		{ "KI", 123 },
-		{ "KM", 124 },
-		{ "KN", 125 },
-		{ "KP", 126 },
-		{ "KR", 127 },
-		{ "KW", 128 },
-		{ "KY", 129 },
-		{ "KZ", 130 },
-		{ "LA", 131 },
-		{ "LB", 132 },
-		{ "LC", 133 },
-		{ "LI", 134 },
-		{ "LK", 135 },
-		{ "LR", 136 },
-		{ "LS", 137 },
-		{ "LT", 138 },
-		{ "LU", 139 },
-		{ "LV", 140 },
-		{ "LY", 141 },
-		{ "MA", 142 },
-		{ "MC", 143 },
-		{ "MD", 144 },
-		{ "ME", 145 },
-		{ "MF", 146 },
-		{ "MG", 147 },
-		{ "MH", 148 },
-		{ "MK", 149 },
-		{ "ML", 150 },
-		{ "MM", 151 },
-		{ "MN", 152 },
-		{ "MO", 153 },
-		{ "MP", 154 },
-		{ "MQ", 155 },
-		{ "MR", 156 },
-		{ "MS", 157 },
-		{ "MT", 158 },
-		{ "MU", 159 },
-		{ "MV", 160 },
-		{ "MW", 161 },
-		{ "MX", 162 },
-		{ "MY", 163 },
-		{ "MZ", 164 },
-		{ "NA", 165 },
-		{ "NC", 166 },
-		{ "NE", 167 },
-		{ "NF", 168 },
-		{ "NG", 169 },
-		{ "NI", 170 },
-		{ "NL", 171 },
-		{ "NO", 172 },
-		{ "NP", 173 },
-		{ "NR", 174 },
-		{ "NU", 175 },
-		{ "NZ", 176 },
-		{ "OM", 177 },
-		{ "PA", 178 },
-		{ "PE", 179 },
-		{ "PF", 180 },
-		{ "PG", 181 },
-		{ "PH", 182 },
-		{ "PK", 183 },
-		{ "PL", 184 },
-		{ "PM", 185 },
-		{ "PN", 186 },
-		{ "PR", 187 },
-		{ "PS", 188 },
-		{ "PT", 189 },
-		{ "PW", 190 },
-		{ "PY", 191 },
-		{ "QA", 192 },
-		{ "RE", 193 },
-		{ "RO", 194 },
-		{ "RS", 195 },
-		{ "RU", 196 },
-		{ "RW", 197 },
-		{ "SA", 198 },
-		{ "SB", 199 },
-		{ "SC", 200 },
-		{ "SD", 201 },
-		{ "SE", 202 },
-		{ "SG", 203 },
-		{ "SH", 204 },
-		{ "SI", 205 },
-		{ "SJ", 206 },
-		{ "SK", 207 },
-		{ "SL", 208 },
-		{ "SM", 209 },
-		{ "SN", 210 },
-		{ "SO", 211 },
-		{ "SR", 212 },
-		{ "SS", 213 },
-		{ "ST", 214 },
-		{ "SV", 215 },
-		{ "SX", 216 },
-		{ "SY", 217 },
-		{ "SZ", 218 },
-		{ "TA", 219 },
-		{ "TC", 220 },
-		{ "TD", 221 },
-		{ "TF", 222 },
-		{ "TG", 223 },
-		{ "TH", 224 },
-		{ "TJ", 225 },
-		{ "TK", 226 },
-		{ "TL", 227 },
-		{ "TM", 228 },
-		{ "TN", 229 },
-		{ "TO", 230 },
-		{ "TR", 231 },
-		{ "TT", 232 },
-		{ "TV", 233 },
-		{ "TW", 234 },
-		{ "TZ", 235 },
-		{ "UA", 236 },
-		{ "UG", 237 },
-		{ "UM", 238 },
-		{ "UN", 239 },
-		{ "US", 240 },
-		{ "UY", 241 },
-		{ "UZ", 242 },
-		{ "VA", 243 },
-		{ "VC", 244 },
-		{ "VE", 245 },
-		{ "VG", 246 },
-		{ "VI", 247 },
-		{ "VN", 248 },
-		{ "VU", 249 },
-		{ "WF", 250 },
-		{ "WS", 251 },
-		{ "XK", 252 },
-		{ "YE", 253 },
-		{ "YT", 254 },
-		{ "ZA", 255 },
-		{ "ZM", 256 },
-		{ "ZW", 257 },
-	};
-
-	std::unordered_map<int, std::unordered_map<int, std::vector<NinjiFrame>>> ninji_paths;
+	// Paths are either owned by the store or point straight into a memory mapped replay cache
+	std::unordered_map<int, LevelFrames> level_frames;
+	// Player of every path in level_frames
+	std::unordered_map<int, std::vector<int>> path_players;
+	// Path in level_frames of every ingested player while ingesting
+	std::unordered_map<int, std::unordered_map<int, uint32_t>> ingested_paths;
+	std::unordered_map<int, ReplayCache> replay_caches;
 	std::unordered_map<int, std::unordered_map<int, int>> ninji_times;
 	std::unordered_map<int, int> best_ninji_time;
 	std::unordered_map<int, int> worst_ninji_time;
 	std::unordered_map<int, std::unordered_map<int, bool>> ninji_is_subworld;
-	int current_player_index = 0;
-	std::unordered_map<std::string, int> pid_to_player;
-	std::unordered_map<int, std::string> player_to_pid;
-	std::unordered_map<int, NinjiInfo> player_info;
+	PlayerRegistry players;
+	NinjiInfo player_info;
 	std::unordered_map<int, std::unordered_map<int, NinjiGlobalInfo>> player_local_info;
 	std::unordered_map<int, LevelBounds> level_bounds;
 	std::unordered_map<int, std::unordered_map<int, bool>> player_facing;
 	std::unordered_map<int, std::vector<NinjiTime>> level_times;
-	std::unordered_map<int, int> level_times_size;
-
-	int row = 0;
-	while(true) {
-		int step = sqlite3_step(res);
-		if(step == SQLITE_ROW) {
-			int data_id = sqlite3_column_int(res, 0);
-
-			if(levels_to_render.count(data_id)) {
-				auto pid = std::string((const char*)sqlite3_column_text(res, 1));
-				int time = sqlite3_column_int(res, 2);
-
-				int player;
-				if(!pid_to_player.count(pid)) {
-					pid_to_player[pid]                  = current_player_index;
-					player_to_pid[current_player_index] = pid;
-					player                              = current_player_index;
-					current_player_index++;
-				} else {
-					player = pid_to_player[pid];
-				}
-
-				uint8_t* replay_data = (uint8_t*)sqlite3_column_blob(res, 3);
-				int replay_size      = sqlite3_column_bytes(res, 3);
-				std::vector<uint8_t> decompressed_replay(replay_size);
-				gzip_decompress(replay_data, replay_size, decompressed_replay);
-
-				std::ofstream outfile("example.bin", std::ios::out | std::ios::binary);
-				outfile.write((const char*)&decompressed_replay[0], decompressed_replay.size());
-				outfile.close();
-
-				uint32_t frames = *(uint32_t*)&decompressed_replay[0x10];
-				toLittleEndian(frames);
-
-				/*
-				uint32_t unk11 = *(uint32_t*)&decompressed_replay[0x18];
-				toLittleEndian(unk11);
-				uint32_t unk12 = *(uint32_t*)&decompressed_replay[0x1A];
-				toLittleEndian(unk12);
-				uint32_t unk13 = *(uint32_t*)&decompressed_replay[0x1C];
-				toLittleEndian(unk13);
-				uint32_t unk14 = *(uint32_t*)&decompressed_replay[0x04];
-				toLittleEndian(unk14);
-				uint32_t unk15 = *(uint32_t*)&decompressed_replay[0x08];
-				toLittleEndian(unk15);
-				uint16_t unk16 = *(uint16_t*)&decompressed_replay[0x16];
-				toLittleEndianShort(unk16);
-				uint8_t unk17   = *(uint8_t*)&decompressed_replay[0x15];
-
-				std::cout << pid << "," << unk11 << "," << unk12 << "," << unk13 << "," << unk14 << "," << unk15 << ","
-						  << unk16 << "," << (int)unk17 << "," << frames << "," << (unk11 - frames) << ","
-						  << (unk12 - frames) << "," << (unk13 - frames) << std::endl;
-
-				continue;
-				*/
-
-				/*
-				// Mario, Mario, Luigi, Luigi, Toad
-				if(std::unordered_set({ 42177, 42513, 43352, 43581, 43588 }).contains(time)) {
-					std::cout << time << ":" << std::endl;
-
-					uint32_t test = *(uint32_t*)&decompressed_replay[0x4];
-					toLittleEndian(test);
-					std::cout << "    0x4: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x8];
-					toLittleEndian(test);
-					std::cout << "    0x8: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x10];
-					toLittleEndian(test);
-					std::cout << "    0x10: " << test << std::endl;
-
-					std::cout << "    0x14: " << (int)decompressed_replay[0x14] << std::endl;
-					std::cout << "    0x15: " << (int)decompressed_replay[0x15] << std::endl;
-
-					uint16_t test2 = *(uint16_t*)&decompressed_replay[0x16];
-					toLittleEndianShort(test2);
-					std::cout << "    0x16: " << test2 << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x18];
-					toLittleEndian(test);
-					std::cout << "    0x18: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x1C];
-					toLittleEndian(test);
-					std::cout << "    0x1C: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x20];
-					toLittleEndian(test);
-					std::cout << "    0x20: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x24];
-					toLittleEndian(test);
-					std::cout << "    0x24: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x28];
-					toLittleEndian(test);
-					std::cout << "    0x28: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x2C];
-					toLittleEndian(test);
-					std::cout << "    0x2C: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x30];
-					toLittleEndian(test);
-					std::cout << "    0x30: " << test << std::endl;
-
-					test = *(uint32_t*)&decompressed_replay[0x34];
-					toLittleEndian(test);
-					std::cout << "    0x34: " << test << std::endl;
-				}*/
-
-				/*
-								std::cout << "YUOOOOOOOOOOOOOOOOOOOOO" << std::endl;
-
-								uint32_t test = *(uint32_t*)&decompressed_replay[0x4];
-								toLittleEndian(test);
-								std::cout << "0x4: " << test << std::endl;
-
-								test = *(uint32_t*)&decompressed_replay[0x8];
-								toLittleEndian(test);
-								std::cout << "0x8: " << test << std::endl;
-
-								test = *(uint32_t*)&decompressed_replay[0x10];
-								toLittleEndian(test);
-								std::cout << "0x10: " << test << std::endl;
-
-								std::cout << "0x14: " << (int)decompressed_replay[0x14] << std::endl;
-								std::cout << "0x15: " << (int)decompressed_replay[0x15] << std::endl;
-
-								uint16_t test2 = *(uint16_t*)&decompressed_replay[0x16];
-								toLittleEndianShort(test2);
-								std::cout << "0x16: " << test2 << std::endl;
-
-								test = *(uint32_t*)&decompressed_replay[0x18];
-								toLittleEndian(test);
-								std::cout << "0x18: " << test << std::endl;
+	// Rank shown for each entry of level_times once sorted, counted against every replay of the level even if only a
+	// sample was ingested
+	std::unordered_map<int, std::vector<int>> level_ranks;
+	// Sorted times of every replay of a sampled level
+	std::unordered_map<int, std::vector<int>> population_times;
+
+	auto get_player = [&](std::string_view pid) {
+		return (int)players.intern(pid);
+	};
 
-								test = *(uint32_t*)&decompressed_replay[0x1C];
-								toLittleEndian(test);
-								std::cout << "0x1C: " << test << std::endl;
+	// Load every level that has an up to date replay cache, the rest go through SQLite
+	ReplayCacheSignature cache_signature;
+	if(use_replay_cache && !get_replay_cache_signature(db, db_path, cache_signature)) {
+		std::cout << "Could not get replay cache signature, ignoring cache" << std::endl;
+		use_replay_cache = false;
+	}
 
-								test = *(uint32_t*)&decompressed_replay[0x20];
-								toLittleEndian(test);
-								std::cout << "0x20: " << test << std::endl;
+	ReplayDump replay_dump;
+	for(auto& pid : dump_pids) {
+		replay_dump.select(pid);
+	}
 
-								test = *(uint32_t*)&decompressed_replay[0x24];
-								toLittleEndian(test);
-								std::cout << "0x24: " << test << std::endl;
+	// Cached levels never see the compressed replays, so everything is ingested while dumping
+	std::vector<int> levels_to_ingest;
+	for(auto data_id : levels_to_render) {
+		if(!use_replay_cache || !replay_dump.empty()
+			|| !replay_caches[data_id].open(get_replay_cache_path(replay_cache_dir, data_id), cache_signature)) {
+			replay_caches.erase(data_id);
+			levels_to_ingest.push_back(data_id);
+			continue;
+		}
 
-								test = *(uint32_t*)&decompressed_replay[0x28];
-								toLittleEndian(test);
-								std::cout << "0x28: " << test << std::endl;
+		auto& cache         = replay_caches[data_id];
+		auto& cache_players = path_players[data_id];
+		for(uint32_t i = 0; i < cache.num_players(); i++) {
+			auto cached                        = cache.player(i);
+			int player                         = get_player(cached.pid);
+			player_local_info[data_id][player] = NinjiGlobalInfo { cached.charactor };
+			ninji_times[data_id][player]       = cached.time;
+			cache_players.push_back(player);
+		}
+		cache.view_frames(level_frames[data_id]);
+		for(auto& time : cache.times()) {
+			level_times[data_id].push_back(NinjiTime { cache_players[time.player], time.time });
+		}
 
-								test = *(uint32_t*)&decompressed_replay[0x2C];
-								toLittleEndian(test);
-								std::cout << "0x2C: " << test << std::endl;
+		std::cout << "Loaded " << cache.num_players() << " cached replays for " << data_id << std::endl;
+	}
 
-								test = *(uint32_t*)&decompressed_replay[0x30];
-								toLittleEndian(test);
-								std::cout << "0x30: " << test << std::endl;
+	if(!levels_to_ingest.empty()) {
+		// Only pull rows for the levels being rendered, every other replay blob is never paged in
+		// Streaming workers open the blobs themselves and only need the rowid
+		std::string replay_query = std::string("SELECT data_id,pid,time,") + (stream_replays ? "rowid" : "replay")
+								   + " FROM ninji WHERE data_id IN (";
+		for(size_t i = 0; i < levels_to_ingest.size(); i++) {
+			replay_query += i == 0 ? "?" : ",?";
+		}
+		replay_query += ")";
+
+		// Pick the rows first from their times alone, then only their blobs are read and decoded
+		if(top_replays > 0) {
+			auto select_start = std::chrono::steady_clock::now();
+			std::unordered_map<int, uint64_t> players_considered;
+			if(!select_top_replays(db, levels_to_ingest, top_replays, players_considered)) {
+				return -1;
+			}
+			for(auto data_id : levels_to_ingest) {
+				std::cout << "Selected the fastest " << top_replays << " replays of " << data_id << " out of "
+						  << players_considered[data_id] << " players" << std::endl;
+			}
+			std::cout << "Selected top replays in "
+					  << std::chrono::duration<double>(std::chrono::steady_clock::now() - select_start).count() << "s"
+					  << std::endl;
+			replay_query += " AND rowid IN (SELECT rowid FROM temp.selected_ninji)";
+		} else if(sample_replays > 0) {
+			auto select_start = std::chrono::steady_clock::now();
+			if(!select_sampled_replays(
+				   db, levels_to_ingest, sample_replays, sample_strata, sample_seed, population_times)) {
+				return -1;
+			}
+			std::cout << "Sampled " << sample_replays << " replays per level from " << sample_strata << " strata in "
+					  << std::chrono::duration<double>(std::chrono::steady_clock::now() - select_start).count() << "s"
+					  << std::endl;
+			replay_query += " AND rowid IN (SELECT rowid FROM temp.selected_ninji)";
+		}
 
-								test = *(uint32_t*)&decompressed_replay[0x34];
-								toLittleEndian(test);
-								std::cout << "0x34: " << test << std::endl;
-								*/
+		// Selections above already only pick best runs. Otherwise players with several rows are filtered while reading
+		// when the index answers the best times cheaply, without it on_replay keeps each player's fastest run instead
+		BestRuns best_runs;
+		if(top_replays == 0 && sample_replays == 0 && has_index(db, "ninji_data_id_time_pid")
+			&& !find_best_runs(db, levels_to_ingest, best_runs)) {
+			return -1;
+		}
 
-				// if(!level_bounds.contains(data_id)) {
-				//	level_bounds[data_id] = LevelBounds {};
-				// }
+		// Players each level can add when the selection above already knows, so interning them never rehashes
+		size_t expected_players = 0;
+		if(top_replays > 0) {
+			expected_players = (size_t)top_replays * levels_to_ingest.size();
+		} else if(sample_replays > 0) {
+			expected_players = (size_t)sample_replays * levels_to_ingest.size();
+		} else {
+			for(auto& level : best_runs) {
+				expected_players += level.second.size();
+			}
+		}
+		players.reserve(players.size() + expected_players);
+
+		IngestOptions ingest_options;
+		ingest_options.num_workers    = ingest_threads;
+		ingest_options.stream_replays = stream_replays;
+		ingest_options.db_path        = db_path;
+		ingest_options.database       = database_options;
+		ingest_options.dump           = replay_dump.empty() ? nullptr : &replay_dump;
+		ingest_options.num_shards     = scan_shards;
+		ingest_options.best_runs      = best_runs.empty() ? nullptr : &best_runs;
+
+		bool stopped_early       = false;
+		uint64_t superseded_runs = 0;
+
+		auto on_replay = [&](IngestedReplay& replay) {
+			int data_id = replay.data_id;
+			int player  = get_player(replay.pid);
+
+			// A player keeps their fastest run, ties go to the first row. A faster run is added as a new path and the
+			// one it replaces is dropped once ingest is done
+			auto [path, first_row] = ingested_paths[data_id].try_emplace(player);
+			if(!first_row) {
+				superseded_runs++;
+				if(replay.time >= ninji_times[data_id][player]) {
+					return true;
+				}
+			}
 
-				uint8_t charactor                  = decompressed_replay[0x14];
-				player_local_info[data_id][player] = NinjiGlobalInfo { charactor };
+			// Frames go straight into the level's store, the replay's own vector is freed as soon as this returns
+			auto& frames = level_frames[data_id];
+			path->second = frames.add_path();
+			frames.append(replay.frames);
+			path_players[data_id].push_back(player);
 
-				// Ninji's are rendered every 4 frames, 2 is because the frames is always two less than it should be
-				int frames_size = (frames + 2) / 4;
+			player_local_info[data_id][player] = NinjiGlobalInfo { replay.charactor };
+			ninji_times[data_id][player]       = replay.time;
 
-				size_t current_offset = 0x3C;
-				bool first            = ninji_paths[data_id].size() == 0;
-				for(int i = 0; i < frames_size; i++) {
-					uint8_t flags = decompressed_replay[current_offset] >> 4;
+#ifdef STOP_EARLY
+			if(ingested_paths[data_id].size() == 300) {
+				// Break early for testing
+				std::cout << "Ending early for testing" << std::endl;
+				stopped_early = true;
+				return false;
+			}
+#endif
 
-					uint8_t player_state = decompressed_replay[current_offset] & 0x0F;
-					current_offset++;
-					uint16_t x = *(uint16_t*)&decompressed_replay[current_offset];
-					current_offset += 2;
-					uint16_t y = *(uint16_t*)&decompressed_replay[current_offset];
-					current_offset += 2;
+			return true;
+		};
 
-					// if(first) {
-					//	std::cout << x << " " << y << " " << std::bitset<8>(flags) << std::endl;
-					// }
+		IngestStats ingest_stats;
+		bool ingest_ok;
+		// Shards can't see the temp table of a top N or sampled ingest, and only have a few rows to read anyway
+		if(scan_shards > 1 && top_replays == 0 && sample_replays == 0) {
+			ingest_ok = ingest_replays_sharded(
+				db, replay_query, levels_to_ingest, ingest_options, on_replay, ingest_stats);
+		} else {
+			rc = sqlite3_prepare_v2(db, replay_query.c_str(), -1, &res, 0);
+			if(rc != SQLITE_OK) {
+				std::cout << "Sqlite could not prepare query" << std::endl;
+				printf("%s: %s\n", sqlite3_errstr(sqlite3_extended_errcode(db)), sqlite3_errmsg(db));
+				return -1;
+			}
 
-					if(flags & 0b00000110) {
-						uint8_t unk1 = decompressed_replay[current_offset];
-						current_offset++;
+			for(size_t i = 0; i < levels_to_ingest.size(); i++) {
+				sqlite3_bind_int(res, i + 1, levels_to_ingest[i]);
+			}
 
-						//std::cout << "This frame flags: " << std::bitset<8>(flags)
-						//		  << " player state: " << (int)player_state << " x: " << x << " y: " << y
-						//		  << " unk1: " << std::bitset<8>(unk1) << std::endl;
+			ingest_ok = ingest_replays(res, ingest_options, on_replay, ingest_stats);
+			sqlite3_finalize(res);
+		}
 
-						// if(first) {
-						//	std::cout << "Unk1 " << std::bitset<8>(unk1) << std::endl;
-						// }
+		if(!ingest_ok) {
+			return -1;
+		}
 
-						if(unk1 & 0b00000110) {
-							// TODO
-						} else if(unk1 & 0b00011000) {
-							current_offset += 2;
-						}
+		ingest_stats.superseded += superseded_runs;
+		print_ingest_stats(ingest_stats);
 
-						// MISSING LOGIC
+		if(!replay_dump.empty()) {
+			if(replay_dump.write(dump_path)) {
+				std::cout << "Dumped " << replay_dump.size() << " replays to " << dump_path << std::endl;
+			} else {
+				std::cout << "Could not write replay dump " << dump_path << std::endl;
+			}
+		}
 
-						// ninji_paths[data_id][player].push_back(
-						//	NinjiFrame { player_state, x, y, (NinjiFrameInfo)unk1, flags });
-						//  if(x & 7 != 1) {
-						//	uint16_t unk2 = *(uint16_t*)&decompressed_replay[current_offset];
-						//	current_offset += 2;
-						//	toLittleEndianShort(unk2);
-						// }
-					} else {
-						//std::cout << "This frame flags: " << std::bitset<8>(flags)
-						//		  << " player state: " << (int)player_state << " x: " << x << " y: " << y << std::endl;
+		for(auto data_id : levels_to_ingest) {
+			auto& frames             = level_frames[data_id];
+			auto& level_paths        = ingested_paths[data_id];
+			auto& level_path_players = path_players[data_id];
+			if(level_paths.size() != frames.num_paths()) {
+				// Only runs a faster one replaced are dropped, in place
+				std::vector<uint8_t> keep(frames.num_paths());
+				std::vector<int> kept_players;
+				for(uint32_t path = 0; path < frames.num_paths(); path++) {
+					keep[path] = level_paths[level_path_players[path]] == path;
+					if(keep[path]) {
+						kept_players.push_back(level_path_players[path]);
 					}
-
-					ninji_paths[data_id][player].push_back(NinjiFrame { player_state, x, y, flags });
-
-					// std::cout << std::bitset<8>(flags) << std::endl;
 				}
+				frames.compact(keep);
+				level_path_players = std::move(kept_players);
+			}
+			frames.shrink_to_fit();
+			ingested_paths.erase(data_id);
 
-				level_times[data_id].push_back(NinjiTime { player, time });
-				ninji_times[data_id][player] = time;
-
-				// exit(0);
+			// Times are only final once every row is in, a player's slower runs may have come first
+			for(auto player : level_path_players) {
+				level_times[data_id].push_back(NinjiTime { player, ninji_times[data_id][player] });
+			}
 
-#ifdef STOP_EARLY
-				if(ninji_paths[data_id].size() == 300) {
-					// Break early for testing
-					std::cout << "Ending early for testing" << std::endl;
-					break;
-				}
-#endif
+			if(!use_replay_cache || stopped_early) {
+				continue;
 			}
 
-			if(row % 1000 == 0) {
-				std::cout << "Handled ninji row " << row << std::endl;
+			// Paths are in the order of the rows they came from, the cache players follow the same order so the times
+			// can refer to them by path index
+			std::vector<ReplayCachePlayer> cache_players;
+			std::vector<ReplayCacheTime> cache_times;
+			std::unordered_map<int, uint32_t> cache_player_index;
+			for(auto player : path_players[data_id]) {
+				cache_player_index[player] = cache_players.size();
+				cache_players.push_back(ReplayCachePlayer {
+					players.pid(player), player_local_info[data_id][player].charactor, ninji_times[data_id][player] });
+			}
+			for(auto& time : level_times[data_id]) {
+				cache_times.push_back(ReplayCacheTime { cache_player_index[time.player], time.time });
 			}
 
-			row++;
-		} else if(step == SQLITE_DONE) {
-			break;
-		} else if(step == SQLITE_BUSY) {
-			// Ignore
+			if(!write_replay_cache(get_replay_cache_path(replay_cache_dir, data_id), cache_signature, cache_players,
+				   cache_times, frames)) {
+				std::cout << "Could not write replay cache for " << data_id << std::endl;
+			}
 		}
 	}
 
-	std::unordered_map<int, std::vector<int>> ninji_paths_sorted;
+	// Path indices into level_frames, slowest first
+	std::unordered_map<int, std::vector<uint32_t>> ninji_paths_sorted;
 	for(auto& ninji_times : level_times) {
 		std::cout << "Sorting times for " << ninji_times.first << std::endl;
 		std::sort(std::begin(ninji_times.second), std::end(ninji_times.second),
@@ -1066,17 +868,136 @@ int main(int argc, char* argv[]) {
 		ninji_times.second.erase(ninji_times.second.begin(), ninji_times.second.end() - 100);
 #endif
 
-		level_times_size[ninji_times.first] = ninji_times.second.size();
+		// Ties in a sample share the best rank among the whole population
+		auto& ranks = level_ranks[ninji_times.first];
+		if(population_times.contains(ninji_times.first)) {
+			auto& population = population_times[ninji_times.first];
+			for(auto& time : ninji_times.second) {
+				auto faster = std::lower_bound(population.begin(), population.end(), time.time) - population.begin();
+				ranks.push_back(faster + 1);
+			}
+		} else {
+			for(size_t index = 0; index < ninji_times.second.size(); index++) {
+				ranks.push_back(ninji_times.second.size() - index);
+			}
+		}
 		worst_ninji_time[ninji_times.first] = ninji_times.second[0].time;
 		best_ninji_time[ninji_times.first]  = ninji_times.second[ninji_times.second.size() - 1].time;
 
+		std::vector<uint32_t> player_path(players.size());
+		auto& level_path_players = path_players[ninji_times.first];
+		for(uint32_t path = 0; path < level_path_players.size(); path++) {
+			player_path[level_path_players[path]] = path;
+		}
 		for(auto& time : ninji_times.second) {
-			ninji_paths_sorted[ninji_times.first].push_back(time.player);
+			ninji_paths_sorted[ninji_times.first].push_back(player_path[time.player]);
 		}
 	}
 
-	// Obtain player info
-	char* player_query = "SELECT name,code,country,mii_image FROM user WHERE pid = ?";
+#ifdef RENDER_PLAYER
+	// States each character is seen in per level, one bit per state. Only their sprites are ever loaded
+	std::unordered_map<int, std::array<uint16_t, NUM_PLAYER_CHARACTORS>> seen_states;
+	for(auto data_id : levels_to_render) {
+		auto& frames = level_frames[data_id];
+		auto& states = seen_states[data_id];
+		states       = {};
+		for(uint32_t path = 0; path < frames.num_paths(); path++) {
+			uint8_t charactor = player_local_info[data_id][path_players[data_id][path]].charactor;
+			if(charactor >= NUM_PLAYER_CHARACTORS) {
+				continue;
+			}
+			uint16_t path_states = 0;
+			for(uint8_t state : frames.path(path).state) {
+				path_states |= 1 << (state & 0x0F);
+			}
+			states[charactor] |= path_states;
+		}
+	}
+#endif
+
+	// Transpose once ranks are known, slices hold ghosts in the order they're drawn
+	std::unordered_map<int, TimeMajorFrames> time_major;
+	if(use_time_major || map_time_major) {
+		use_time_major = true;
+		for(auto data_id : levels_to_render) {
+			auto transpose_start = std::chrono::steady_clock::now();
+			std::string table_path = map_time_major ? get_time_major_path(time_major_dir, data_id) : std::string();
+			if(!time_major[data_id].build(level_frames[data_id], ninji_paths_sorted[data_id], table_path)) {
+				std::cout << "Could not build time major frames for " << data_id << std::endl;
+				return -1;
+			}
+			std::cout << "Transposed " << data_id << " into " << time_major[data_id].num_slices() << " frames ("
+					  << time_major[data_id].size_bytes() / 1000000.0 << " MB) in "
+					  << std::chrono::duration<double>(std::chrono::steady_clock::now() - transpose_start).count()
+					  << "s" << std::endl;
+		}
+	}
+
+	// Decoded frames are dropped once compressed, anything needing them has to come before this
+	std::unordered_map<int, CompressedPaths> compressed_paths;
+	if(compress_paths) {
+		for(auto data_id : levels_to_render) {
+			auto& frames = level_frames[data_id];
+			compressed_paths[data_id].build(frames);
+			std::cout << "Compressed " << frames.num_frames() << " frames of " << data_id << " from "
+					  << frames.num_frames() * 6 / 1000000.0 << " MB to "
+					  << compressed_paths[data_id].size_bytes() / 1000000.0 << " MB" << std::endl;
+			frames = LevelFrames();
+		}
+	}
+
+	// Same for the prefix trie, its ghosts are ranks rather than paths
+	std::unordered_map<int, PathTrie> path_tries;
+	if(share_prefixes) {
+		for(auto data_id : levels_to_render) {
+			auto& frames = level_frames[data_id];
+			std::vector<uint8_t> rank_charactors;
+			for(auto path : ninji_paths_sorted[data_id]) {
+				rank_charactors.push_back(player_local_info[data_id][path_players[data_id][path]].charactor);
+			}
+			path_tries[data_id].build(frames, ninji_paths_sorted[data_id], rank_charactors);
+			std::cout << "Shared prefixes of " << data_id << " take " << path_tries[data_id].size_bytes() / 1000000.0
+					  << " MB instead of " << frames.num_frames() * 6 / 1000000.0 << " MB" << std::endl;
+			frames = LevelFrames();
+		}
+	}
+
+	// Obtain player info, every pid goes into a temp table so user is joined once instead of looked up per player
+	auto player_query_start = std::chrono::steady_clock::now();
+
+	rc = sqlite3_exec(db,
+		"CREATE TEMP TABLE IF NOT EXISTS render_pid(pid TEXT PRIMARY KEY, player INTEGER);"
+		"DELETE FROM temp.render_pid;"
+		"BEGIN",
+		NULL, NULL, &err_msg);
+	if(rc != SQLITE_OK) {
+		std::cout << "Sqlite could not create pid table: " << err_msg << std::endl;
+		sqlite3_free(err_msg);
+		return -1;
+	}
+
+	rc = sqlite3_prepare_v2(db, "INSERT INTO temp.render_pid(pid,player) VALUES (?,?)", -1, &res, 0);
+	if(rc != SQLITE_OK) {
+		std::cout << "Sqlite could not prepare" << std::endl;
+		return -1;
+	}
+
+	for(uint32_t player = 0; player < players.size(); player++) {
+		auto pid = players.pid(player);
+		sqlite3_bind_text(res, 1, pid.data(), pid.size(), SQLITE_STATIC);
+		sqlite3_bind_int(res, 2, player);
+		if(sqlite3_step(res) != SQLITE_DONE) {
+			std::cout << "Sqlite could not insert pid: " << sqlite3_errmsg(db) << std::endl;
+			return -1;
+		}
+		sqlite3_reset(res);
+	}
+
+	sqlite3_finalize(res);
+	sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+
+	char* player_query = "SELECT r.player,u.name,u.code,u.country,u.mii_image FROM temp.render_pid r JOIN user u ON "
+						 "u.pid = r.pid ORDER BY r.player";
 	rc                 = sqlite3_prepare_v2(db, player_query, -1, &res, 0);
 	if(rc != SQLITE_OK) {
 		std::cout << "Sqlite could not prepare" << std::endl;
@@ -1086,47 +1007,52 @@ int main(int argc, char* argv[]) {
 	std::vector<std::string> miis_to_download; // JPGs
 	std::vector<int> miis_to_download_player;
 	std::unordered_map<int, std::string> mii_images;
-	std::unordered_set<std::string> used_flags;
+	// Indexed by country id
+	std::vector<bool> used_countries(NUM_COUNTRIES + 1);
 
-	row = 0;
-	for(auto& player : pid_to_player) {
-		sqlite3_bind_text(res, 1, player.first.c_str(), player.first.size(), NULL);
-
-		while(true) {
-			int step = sqlite3_step(res);
-			if(step == SQLITE_ROW) {
-				auto name          = std::string((const char*)sqlite3_column_text(res, 0));
-				auto code          = std::string((const char*)sqlite3_column_text(res, 1));
-				auto country       = std::string((const char*)sqlite3_column_text(res, 2));
-				auto mii_image_url = std::string((const char*)sqlite3_column_text(res, 3));
-
-				player_info[player.second] = NinjiInfo { name, code, country };
-				miis_to_download.push_back(mii_image_url);
-				miis_to_download_player.push_back(player.second);
-				used_flags.emplace(country);
-			} else if(step == SQLITE_BUSY) {
-				// Ignore
-			} else if(step == SQLITE_DONE) {
-				break;
-			}
-		}
+	miis_to_download.reserve(players.size());
+	miis_to_download_player.reserve(players.size());
+	player_info.resize(players.size());
 
-		row++;
+	int row = 0;
+	while(true) {
+		int step = sqlite3_step(res);
+		if(step == SQLITE_ROW) {
+			int player         = sqlite3_column_int(res, 0);
+			auto mii_image_url = std::string((const char*)sqlite3_column_text(res, 4));
+			uint16_t country   = intern_country(column_string_view(res, 3));
 
-		if(row % 1000 == 0) {
-			std::cout << "Handled user row " << row << std::endl;
-		}
+			player_info.name[player]    = player_info.strings.add(column_string_view(res, 1));
+			player_info.code[player]    = player_info.strings.add(column_string_view(res, 2));
+			player_info.country[player] = country;
+			miis_to_download.push_back(std::move(mii_image_url));
+			miis_to_download_player.push_back(player);
+			used_countries[country] = true;
 
-		sqlite3_reset(res);
-		sqlite3_clear_bindings(res);
+			row++;
+
+			if(row % 1000 == 0) {
+				std::cout << "Handled user row " << row << std::endl;
+			}
+		} else if(step == SQLITE_BUSY) {
+			// Ignore
+		} else {
+			break;
+		}
 	}
 
+	std::cout << "Looked up " << row << " of " << players.size() << " players in "
+			  << std::chrono::duration<double>(std::chrono::steady_clock::now() - player_query_start).count() << "s, "
+			  << player_info.strings.size_bytes() / 1000000.0 << " MB of names and codes in "
+			  << player_info.strings.num_blocks() << " blocks" << std::endl;
+
 	sqlite3_finalize(res);
 	sqlite3_close(db);
+	db_prefetcher.stop();
 
 #ifdef RENDER_PLAYER
 	// Download all images
-	downloadMiis(miis_to_download, miis_to_download_player, mii_images, player_to_pid);
+	downloadMiis(miis_to_download, miis_to_download_player, mii_images, players);
 	std::cout << "Downloaded " << mii_images.size() << " images" << std::endl;
 	row = 0;
 	for(auto& image : mii_images) {
@@ -1150,7 +1076,7 @@ int main(int argc, char* argv[]) {
 			SkRect::MakeWH(24 * 2 * SIZE_MULTIPLIER, 24 * 2 * SIZE_MULTIPLIER), SkSamplingOptions(SkFilterMode::kNearest),
 			nullptr, SkCanvas::kStrict_SrcRectConstraint);
 
-		player_info[image.first].mii_image = rasterSurface->makeImageSnapshot();
+		player_info.mii_image[image.first] = rasterSurface->makeImageSnapshot();
 
 		row++;
 
@@ -1167,92 +1093,20 @@ int main(int argc, char* argv[]) {
 
 	std::cout << "Cleared Mii vectors" << std::endl;
 
-	// Create images for players
-	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, sk_sp<SkImage>>>> player_image;
-	std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, sk_sp<SkImage>>>> player_mirrored_image;
-	for(auto data_id : levels_to_render) {
-		for(int player = 0; player < 4; player++) {
-			std::string player_name;
-			switch(player) {
-			case 0:
-				player_name = "mario";
-				break;
-			case 1:
-				player_name = "luigi";
-				break;
-			case 2:
-				player_name = "toad";
-				break;
-			case 3:
-				player_name = "toadette";
-				break;
-			}
-
-			// https://github.com/kinnay/Nintendo-File-Formats/wiki/SMM-2-Ninji-Ghosts#player-state
-			for(int state = 0; state < 16; state++) {
-				// TODO some states have multiple possible states within them (eg walking)
-				// Gamestyles also change images
-				// 0 (standing, walking, running): column 3 row 2
-				// 1 (jumping): column 7 row 2
-				// 2 (swimming): column 10 row 2
-				// 3 (climbing): column 14 row 2
-				// 4 ("hipat" and link down slash): NONE
-				// 5 (slipping): column 15 row 2
-				// 6 ("wsld"): NONE
-				// 7 (clear pipe and dry bones): column 17 row 2 second dry bones
-				// 8 (cat attack and clown car): column 19 row 2 clown car in folder
-				// 9 (tree top and lakitu cloud): column 19 row 2 cloud in other spritesheet
-				// 10 (goomba shoe, koopa troopa, or yoshi): column 19 row 2 yoshi in other spritesheet
-				// 11 (walking cat): column 3 row 2
-				// 12 (unknown)
-				SkBitmap* bitmap     = new SkBitmap();
-				std::string filename = std::string("../assets/players/") + player_name + "/" + gamestyle[data_id] + "/"
-									   + std::to_string(state) + ".png";
-
-				if(!std::filesystem::exists(filename)) {
-					filename = std::string("../assets/players/") + player_name + "/" + std::to_string(state) + ".png";
-				}
+	// Player sprites are only loaded once a level needs them, and shared between levels of the same game style
+	PlayerSpriteCache player_sprites("../assets/players/", SIZE_MULTIPLIER);
+#endif
 
-				std::unique_ptr<SkCodec> player_sprite
-					= SkCodec::MakeFromStream(SkStream::MakeFromFile(filename.c_str()));
-				SkImageInfo info = player_sprite->getInfo().makeColorType(kBGRA_8888_SkColorType);
-				bitmap->allocPixels(info);
-				player_sprite->getPixels(info, bitmap->getPixels(), bitmap->rowBytes());
-				bitmap->setImmutable();
-
-				// Increase size of sprite
-				sk_sp<SkSurface> rasterSurface = SkSurface::MakeRasterN32Premul(
-					bitmap->width() * SIZE_MULTIPLIER, bitmap->height() * SIZE_MULTIPLIER);
-				rasterSurface->getCanvas()->drawImageRect(bitmap->asImage(),
-					SkRect::MakeLTRB(0, 0, bitmap->width(), bitmap->height()),
-					SkRect::MakeWH(bitmap->width() * SIZE_MULTIPLIER, bitmap->height() * SIZE_MULTIPLIER),
-					SkSamplingOptions(SkFilterMode::kNearest), nullptr, SkCanvas::kStrict_SrcRectConstraint);
-				player_image[data_id][player][state] = rasterSurface->makeImageSnapshot();
-
-				// Sprite facing other direction
-				rasterSurface = SkSurface::MakeRasterN32Premul(
-					bitmap->width() * SIZE_MULTIPLIER, bitmap->height() * SIZE_MULTIPLIER);
-				// Scale for facing opposite direction
-				rasterSurface->getCanvas()->translate(bitmap->width() * SIZE_MULTIPLIER, 0);
-				rasterSurface->getCanvas()->scale(-1, 1);
-				rasterSurface->getCanvas()->drawImageRect(bitmap->asImage(),
-					SkRect::MakeLTRB(0, 0, bitmap->width(), bitmap->height()),
-					SkRect::MakeWH(bitmap->width() * SIZE_MULTIPLIER, bitmap->height() * SIZE_MULTIPLIER),
-					SkSamplingOptions(SkFilterMode::kNearest), nullptr, SkCanvas::kStrict_SrcRectConstraint);
-				player_mirrored_image[data_id][player][state] = rasterSurface->makeImageSnapshot();
-			}
+	// Create images for flags, indexed by country id. Unknown countries have none
+	std::vector<sk_sp<SkImage>> flag_image(NUM_COUNTRIES + 1);
+	for(uint16_t country = 0; country < NUM_COUNTRIES; country++) {
+		if(!used_countries[country]) {
+			continue;
 		}
-	}
-
-	std::cout << "Created player images" << std::endl;
-#endif
 
-	// Create images for flags
-	std::unordered_map<std::string, sk_sp<SkImage>> flag_image;
-	for(auto& flag : used_flags) {
 		SkBitmap* bitmap                    = new SkBitmap();
-		std::unique_ptr<SkCodec> flag_codec = SkCodec::MakeFromStream(
-			SkStream::MakeFromFile((std::string("../assets/flags/") + flag + ".png").c_str()));
+		std::unique_ptr<SkCodec> flag_codec = SkCodec::MakeFromStream(SkStream::MakeFromFile(
+			(std::string("../assets/flags/") + std::string(country_code(country)) + ".png").c_str()));
 		SkImageInfo info = flag_codec->getInfo().makeColorType(kBGRA_8888_SkColorType);
 		bitmap->allocPixels(info);
 		flag_codec->getPixels(info, bitmap->getPixels(), bitmap->rowBytes());
@@ -1263,7 +1117,7 @@ int main(int argc, char* argv[]) {
 			SkRect::MakeWH(36 * 2 * SIZE_MULTIPLIER, 24 * 2 * SIZE_MULTIPLIER), SkSamplingOptions(SkFilterMode::kNearest),
 			nullptr, SkCanvas::kStrict_SrcRectConstraint);
 
-		flag_image[flag] = rasterSurface->makeImageSnapshot();
+		flag_image[country] = rasterSurface->makeImageSnapshot();
 	}
 
 	std::cout << "Created flag images" << std::endl;
@@ -1498,6 +1352,20 @@ int main(int argc, char* argv[]) {
 	SkFont timerFont(SkTypeface::MakeFromFile("../assets/fonts/NotoSansJP-Bold.otf"));
 	timerFont.setSize(180 * SIZE_MULTIPLIER);
 	timerFont.setEdging(SkFont::Edging::kAlias);
+	// Bounds of the widest time the timer can show, relative to where it's drawn. Damaging all of it every frame keeps
+	// the timer on the same tiles whatever digits it shows
+	SkRect timer_bounds;
+	{
+		char widest_digit = '0';
+		for(char digit = '1'; digit <= '9'; digit++) {
+			if(timerFont.measureText(&digit, 1, SkTextEncoding::kUTF8)
+				> timerFont.measureText(&widest_digit, 1, SkTextEncoding::kUTF8)) {
+				widest_digit = digit;
+			}
+		}
+		auto widest_time = fmt::format("{0}{0}:{0}{0}.{0}{0}{0}", widest_digit);
+		timerFont.measureText(widest_time.c_str(), widest_time.size(), SkTextEncoding::kUTF8, &timer_bounds);
+	}
 
 	SkPaint hoverNamePaint;
 	hoverNamePaint.setAntiAlias(false);
@@ -1530,8 +1398,27 @@ int main(int argc, char* argv[]) {
 			levels_height = level_overworld_image[data_id]->height() + 240 * SIZE_MULTIPLIER;
 		}
 
-		// Show percent of countries so far
-		std::unordered_map<std::string, int> countries_so_far;
+		// Show percent of countries so far. Players past the flagpole per country id, and the countries seen so far
+		// from most to least players with each one's position in that order
+		std::vector<int> country_counts(NUM_COUNTRIES + 1);
+		std::vector<uint16_t> countries_by_count;
+		std::vector<uint16_t> country_positions(NUM_COUNTRIES + 1);
+		auto count_country = [&](uint16_t country) {
+			if(country_counts[country]++ == 0) {
+				country_positions[country] = countries_by_count.size();
+				countries_by_count.push_back(country);
+			}
+			// Counts only go up by one, so the order stays sorted by moving the country past the ones it overtook
+			uint16_t position = country_positions[country];
+			while(position > 0 && country_counts[countries_by_count[position - 1]] < country_counts[country]) {
+				uint16_t overtaken               = countries_by_count[position - 1];
+				countries_by_count[position]     = overtaken;
+				country_positions[overtaken]     = position;
+				countries_by_count[position - 1] = country;
+				country_positions[country]       = position - 1;
+				position--;
+			}
+		};
 
 #ifdef RENDER_VIDEO
 		int width       = leaderboard_x_offset + leaderboard_width;
@@ -1627,11 +1514,181 @@ int main(int argc, char* argv[]) {
 		std::cout << "Opened output video file " << data_id << std::endl;
 #endif
 
-		std::unordered_set<int> seen_states;
+		// One cursor per rank, moved forward as player_update grows
+		std::vector<PathCursor> path_cursors;
+		if(compress_paths) {
+			for(auto path_index : ninji_paths_sorted[data_id]) {
+				path_cursors.push_back(compressed_paths[data_id].cursor(path_index));
+			}
+		}
+		DecodedPath decoded_path;
+		// Node at player_update + 1 of every rank still on a shared route, or PATH_TRIE_NONE
+		std::vector<uint32_t> shared_nodes(ninji_paths_sorted[data_id].size(), PATH_TRIE_NONE);
+
+		// Everything that stays the same for the whole level, the upscaled level images and both "greenscreens" for
+		// chromakey
+		auto draw_background = [&](SkCanvas* background_canvas) {
+			background_canvas->clear(SK_ColorBLACK);
+			background_canvas->drawImage(level_overworld_image[data_id], 0, 120 * SIZE_MULTIPLIER);
+			if(level_subworld_image.contains(data_id)) {
+				background_canvas->drawImage(
+					level_subworld_image[data_id], 0, level_overworld_image[data_id]->height() + 360 * SIZE_MULTIPLIER);
+			}
+
+			SkPaint greenscreenPaint;
+			greenscreenPaint.setColor(SkColorSetARGB(255, 190, 0, 255));
+			background_canvas->drawRect(
+				SkRect::MakeXYWH(leaderboard_x_offset, 0, leaderboard_width, leaderboard_height), greenscreenPaint);
+			background_canvas->drawRect(
+				SkRect::MakeXYWH(0, levels_height, leaderboard_x_offset + leaderboard_width, countries_graph_height),
+				greenscreenPaint);
+		};
+
+#ifdef RENDER_VIDEO
+		// Composed once into its own buffer, every frame then starts with one copy of it instead of clearing and
+		// redrawing hundreds of MB of scaled pixels
+		auto background_start = std::chrono::steady_clock::now();
+		std::vector<uint8_t> backgroundMemory(pixelMemory.size());
+		{
+			sk_sp<SkSurface> background_surface = SkSurface::MakeRasterDirect(info, backgroundMemory.data(), rowBytes);
+			draw_background(background_surface->getCanvas());
+		}
+		double compose_seconds
+			= std::chrono::duration<double>(std::chrono::steady_clock::now() - background_start).count();
+		std::cout << "Composed static layer for " << data_id << " in " << compose_seconds * 1000.0 << "ms"
+				  << std::endl;
+
+		// Time spent per stage over the whole level
+		double copy_seconds   = 0;
+		double draw_seconds   = 0;
+		double encode_seconds = 0;
+#endif
+
+		// Every flag and every ghost sprite of the level packed into one image. Ghosts are drawn with one drawAtlas
+		// call per frame instead of a draw each, and flags with one per scoreboard redraw
+		SpriteAtlas sprite_atlas;
+		std::vector<int> flag_sprite(flag_image.size());
+		for(size_t country = 0; country < flag_image.size(); country++) {
+			flag_sprite[country] = sprite_atlas.add(flag_image[country]);
+		}
+#ifdef RENDER_PLAYER
+		// Atlas ids per character and state, facing right and mirrored. Only states the level's ghosts are seen in
+		// are loaded and packed, the rest stay -1
+		int ghost_sprites[NUM_PLAYER_CHARACTORS][NUM_PLAYER_STATES][2];
+		size_t sprites_before = player_sprites.num_loaded();
+		for(int charactor = 0; charactor < NUM_PLAYER_CHARACTORS; charactor++) {
+			for(int state = 0; state < NUM_PLAYER_STATES; state++) {
+				ghost_sprites[charactor][state][0] = -1;
+				ghost_sprites[charactor][state][1] = -1;
+				if(seen_states[data_id][charactor] & (1 << state)) {
+					auto& sprite                       = player_sprites.get(gamestyle[data_id], charactor, state);
+					ghost_sprites[charactor][state][0] = sprite_atlas.add(sprite.image);
+					ghost_sprites[charactor][state][1] = sprite_atlas.add(sprite.mirrored);
+				}
+			}
+		}
+		auto ghost_sprite = [&](uint8_t charactor, uint8_t state, bool mirrored) {
+			if(charactor >= NUM_PLAYER_CHARACTORS || state >= NUM_PLAYER_STATES) {
+				return -1;
+			}
+			return ghost_sprites[charactor][state][mirrored];
+		};
+		std::cout << "Loaded " << player_sprites.num_loaded() - sprites_before << " player sprites for " << data_id
+				  << ", " << player_sprites.num_loaded() << " cached (" << player_sprites.size_bytes() / 1000000.0
+				  << " MB)" << std::endl;
+#endif
+		if(!sprite_atlas.build()) {
+			std::cout << "Could not build sprite atlas for " << data_id << std::endl;
+			return 1;
+		}
+		SpriteBatch ghost_batch(sprite_atlas);
+		SpriteBatch flag_batch(sprite_atlas);
+
+		// Counts and names of ghosts, drawn after the batch so they stay over every sprite
+		struct GhostLabel {
+			std::string text;
+			SkPoint position;
+		};
+		std::vector<GhostLabel> ghost_labels;
+		size_t num_ghost_labels = 0;
+
+		// Damage is only tracked on the raster surface, and lines are all redrawn from the start every frame
+		bool track_damage = false;
+#if defined(RENDER_VIDEO) && !defined(RENDER_LINES)
+		track_damage = dirty_rects;
+#endif
+		DamageTracker damage;
+		std::vector<DamageRect> damage_rects;
+		uint64_t restored_pixels = 0;
+		// Players left when the leaderboard and countries graph were last drawn. They only change when a player
+		// finishes, so with damage tracked they stay in place until then unless restored tiles cut into them
+		size_t scoreboard_players = SIZE_MAX;
+#ifdef RENDER_VIDEO
+		damage.reset(width, height);
+#endif
+
+		// Bounds of what's about to be drawn, a couple of pixels wider for glyph edges
+		auto damage_sprite = [&](int sprite, float x, float y) {
+			if(track_damage) {
+				const SkRect& rect = sprite_atlas.rect(sprite);
+				damage.add(x - 1, y - 1, x + rect.width() + 2, y + rect.height() + 2);
+			}
+		};
+		auto damage_text = [&](const char* text, size_t size, const SkFont& font, float x, float y) {
+			if(track_damage) {
+				SkRect bounds;
+				font.measureText(text, size, SkTextEncoding::kUTF8, &bounds);
+				damage.add(x + bounds.left() - 2, y + bounds.top() - 2, x + bounds.right() + 3, y + bounds.bottom() + 3);
+			}
+		};
+		// Label strings are reused across frames
+		auto add_ghost_label = [&](std::string_view text, float x, float y) {
+			damage_text(text.data(), text.size(), hoverNameFont, x, y);
+			if(num_ghost_labels == ghost_labels.size()) {
+				ghost_labels.emplace_back();
+			}
+			ghost_labels[num_ghost_labels].text.assign(text);
+			ghost_labels[num_ghost_labels].position = SkPoint::Make(x, y);
+			num_ghost_labels++;
+		};
+
+		// Frames are recorded and then played back over bands of the frame in parallel. Lines read the frame back while
+		// it's drawn, so they're always drawn directly
+		bool record_frames = false;
+#if defined(RENDER_VIDEO) && !defined(RENDER_LINES)
+		record_frames = render_threads > 1 || band_scaling_frame >= 0;
+#endif
+#ifdef RENDER_VIDEO
+		SkCanvas* surface_canvas = canvas;
+		BandRenderer band_renderer(record_frames ? render_threads : 1);
+		if(!band_renderer.set_target(info, pixelMemory.data(), rowBytes)) {
+			std::cout << "Could not create band surfaces for " << data_id << std::endl;
+			record_frames = false;
+		}
+		// Lets playback skip the draws that miss a band
+		SkRTreeFactory band_bounds;
+		SkPictureRecorder recorder;
+		double playback_seconds = 0;
+#endif
+
 		std::unordered_map<int, tk::spline> direction_facing_spline_x_player;
 		std::unordered_map<int, tk::spline> direction_facing_spline_y_player;
 		while(!stop) {
-			canvas->clear(SK_ColorBLACK);
+#ifdef RENDER_VIDEO
+			auto frame_start = std::chrono::steady_clock::now();
+			if(track_damage) {
+				restored_pixels += damage.restore(pixelMemory.data(), backgroundMemory.data(), rowBytes);
+			} else {
+				memcpy(pixelMemory.data(), backgroundMemory.data(), pixelMemory.size());
+			}
+			auto draw_start = std::chrono::steady_clock::now();
+			copy_seconds += std::chrono::duration<double>(draw_start - frame_start).count();
+			if(record_frames) {
+				canvas = recorder.beginRecording(SkRect::MakeWH(width, height), &band_bounds);
+			}
+#else
+			draw_background(canvas);
+#endif
 
 #ifdef RENDER_SCREEN
 			SDL_Event event;
@@ -1671,42 +1728,59 @@ int main(int argc, char* argv[]) {
 			}
 #endif
 
-			canvas->drawImage(level_overworld_image[data_id], 0, 120 * SIZE_MULTIPLIER);
-			if(level_subworld_image.contains(data_id)) {
-				canvas->drawImage(
-					level_subworld_image[data_id], 0, level_overworld_image[data_id]->height() + 360 * SIZE_MULTIPLIER);
+			// The leaderboard and the countries graph overlap on a short level, so they're restored and redrawn together.
+			// The timer sits on the graph and is restored every frame, its tiles alone only need the graph redrawn under
+			// them
+			int leaderboard_left   = leaderboard_x_offset;
+			int leaderboard_right  = leaderboard_x_offset + leaderboard_width;
+			int graph_top          = levels_height;
+			int graph_bottom       = levels_height + countries_graph_height;
+			int timer_y            = levels_height + 800;
+			DamageRect timer_tiles = damage.tile_bounds(timer_x + timer_bounds.left() - 2,
+				timer_y + timer_bounds.top() - 2, timer_x + timer_bounds.right() + 3, timer_y + timer_bounds.bottom() + 3);
+			bool draw_scoreboard   = !track_damage || level_times[data_id].size() != scoreboard_players
+								    || damage.restored(leaderboard_left, 0, leaderboard_right, leaderboard_height)
+								    || damage.restored(0, graph_top, leaderboard_right, graph_bottom, timer_tiles);
+			bool draw_timer_graph  = !draw_scoreboard
+									&& damage.restored(
+										timer_tiles.left, timer_tiles.top, timer_tiles.right, timer_tiles.bottom);
+			scoreboard_players     = level_times[data_id].size();
+#ifdef RENDER_VIDEO
+			if(track_damage && draw_scoreboard) {
+				damage.restore_rect(pixelMemory.data(), backgroundMemory.data(), rowBytes, leaderboard_left, 0,
+					leaderboard_right, leaderboard_height);
+				damage.restore_rect(pixelMemory.data(), backgroundMemory.data(), rowBytes, 0, graph_top,
+					leaderboard_right, graph_bottom);
 			}
-
-			// Draw both "greenscreens" for chromakey
-			SkPaint greenscreenPaint;
-			greenscreenPaint.setColor(SkColorSetARGB(255, 190, 0, 255));
-			canvas->drawRect(
-				SkRect::MakeXYWH(leaderboard_x_offset, 0, leaderboard_width, leaderboard_height), greenscreenPaint);
-			canvas->drawRect(
-				SkRect::MakeXYWH(0, levels_height, leaderboard_x_offset + leaderboard_width, countries_graph_height),
-				greenscreenPaint);
+#endif
 
 			// Draw leaderboard
-			for(int rank = 0; rank < 36; rank++) {
-				int index = level_times[data_id].size() - 1 - rank;
-				if(index <= 0)
-					break;
+			if(draw_scoreboard) {
+				for(int rank = 0; rank < 36; rank++) {
+					int index = level_times[data_id].size() - 1 - rank;
+					if(index <= 0)
+						break;
 
-				auto& time   = level_times[data_id][index];
-				auto& player = player_info[time.player];
+					auto& time = level_times[data_id][index];
+					auto& mii  = player_info.mii_image[time.player];
+					auto& name = player_info.name[time.player];
 
-				int y                  = (rank + 1) * 36 * 2 * SIZE_MULTIPLIER;
-				std::string rankString = std::to_string(level_times_size[data_id] - index);
-				canvas->drawSimpleText(rankString.c_str(), rankString.size(), SkTextEncoding::kUTF8,
-					leaderboard_x_offset + 8 * SIZE_MULTIPLIER, y, rankFont, leaderboardFontPaint);
-				if(player.mii_image) {
-					canvas->drawImage(
-						player.mii_image, leaderboard_x_offset + 176 * SIZE_MULTIPLIER, y - 20 * 2 * SIZE_MULTIPLIER);
+					int y                  = (rank + 1) * 36 * 2 * SIZE_MULTIPLIER;
+					std::string rankString = std::to_string(level_ranks[data_id][index]);
+					canvas->drawSimpleText(rankString.c_str(), rankString.size(), SkTextEncoding::kUTF8,
+						leaderboard_x_offset + 8 * SIZE_MULTIPLIER, y, rankFont, leaderboardFontPaint);
+					if(mii) {
+						canvas->drawImage(mii, leaderboard_x_offset + 176 * SIZE_MULTIPLIER, y - 20 * 2 * SIZE_MULTIPLIER);
+					}
+					int flag = flag_sprite[player_info.country[time.player]];
+					if(flag >= 0) {
+						flag_batch.add(
+							flag, leaderboard_x_offset + 236 * SIZE_MULTIPLIER, y - 20 * 2 * SIZE_MULTIPLIER);
+					}
+					canvas->drawSimpleText(name.data(), name.size(), SkTextEncoding::kUTF8,
+						leaderboard_x_offset + 316 * SIZE_MULTIPLIER, y, nameFont, leaderboardFontPaint);
 				}
-				canvas->drawImage(
-					flag_image[player.country], leaderboard_x_offset + 236 * SIZE_MULTIPLIER, y - 20 * 2 * SIZE_MULTIPLIER);
-				canvas->drawSimpleText(player.name.c_str(), player.name.size(), SkTextEncoding::kUTF8,
-					leaderboard_x_offset + 316 * SIZE_MULTIPLIER, y, nameFont, leaderboardFontPaint);
+				flag_batch.draw(canvas);
 			}
 
 			// Draw timer
@@ -1715,42 +1789,56 @@ int main(int argc, char* argv[]) {
 			int seconds      = (time / 1000) % 60;
 			int milliseconds = time % 1000;
 			auto time_string = fmt::format("{:0>2}:{:0>2}.{:0>3}", minutes, seconds, milliseconds);
+			if(track_damage) {
+				damage.add(timer_tiles.left, timer_tiles.top, timer_tiles.right, timer_tiles.bottom);
+			}
 			canvas->drawSimpleText(time_string.c_str(), strlen(time_string.c_str()), SkTextEncoding::kUTF8, timer_x,
-				levels_height + 800, timerFont, timerPaint);
+				timer_y, timerFont, timerPaint);
 
-			// Draw countries graph
-			std::vector<std::pair<std::string, int>> sorted_country_counts;
-			for(auto& entry : countries_so_far) {
-				sorted_country_counts.push_back(std::make_pair(entry.first, entry.second));
+			// Draw countries graph, only into the timer's tiles when nothing else of it was restored
+			if(draw_timer_graph) {
+				canvas->save();
+				canvas->clipRect(
+					SkRect::MakeLTRB(timer_tiles.left, timer_tiles.top, timer_tiles.right, timer_tiles.bottom));
 			}
-
-			std::sort(std::begin(sorted_country_counts), std::end(sorted_country_counts),
-				[](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
-
-			int biggest_size = 0;
-			int total_height = countries_graph_height - 45;
-			for(int i = 0; i < sorted_country_counts.size(); i++) {
-				auto& entry = sorted_country_counts[i];
-				if(i == 0) {
-					biggest_size = entry.second;
+			if(draw_scoreboard || draw_timer_graph) {
+				// Flags go down first, the bars end a few pixels into them and are drawn on top
+				for(int i = 0; i < countries_by_count.size(); i++) {
+					uint16_t country = countries_by_count[i];
+					if(flag_sprite[country] >= 0) {
+						flag_batch.add(flag_sprite[country], i * 54 * SIZE_MULTIPLIER + 9 * SIZE_MULTIPLIER,
+							levels_height + countries_graph_height - 24 * SIZE_MULTIPLIER);
+					}
 				}
+				flag_batch.draw(canvas);
+
+				int biggest_size = 0;
+				int total_height = countries_graph_height - 45;
+				for(int i = 0; i < countries_by_count.size(); i++) {
+					uint16_t country = countries_by_count[i];
+					int count        = country_counts[country];
+					if(i == 0) {
+						biggest_size = count;
+					}
 
-				int start_x = i * 54 * SIZE_MULTIPLIER;
-				canvas->drawImage(flag_image[entry.first], start_x + 9 * SIZE_MULTIPLIER,
-					levels_height + countries_graph_height - 24 * SIZE_MULTIPLIER);
-				std::string numString = std::to_string(entry.second);
-				canvas->drawSimpleText(numString.c_str(), numString.size(), SkTextEncoding::kUTF8,
-					start_x + 7 * SIZE_MULTIPLIER, levels_height + countries_graph_height - 30 * SIZE_MULTIPLIER,
-					countryCountFont, leaderboardFontPaint);
-
-				// Draw graph bar
-				int bar_height = total_height * ((float)entry.second / biggest_size);
-				SkPaint barPaint;
-				barPaint.setColor(SK_ColorWHITE);
-				canvas->drawRect(
-					SkRect::MakeXYWH((float)start_x + 9.0f * SIZE_MULTIPLIER,
-						(float)(levels_height + total_height - bar_height), 36.0f * SIZE_MULTIPLIER, (float)bar_height),
-					barPaint);
+					int start_x           = i * 54 * SIZE_MULTIPLIER;
+					std::string numString = std::to_string(count);
+					canvas->drawSimpleText(numString.c_str(), numString.size(), SkTextEncoding::kUTF8,
+						start_x + 7 * SIZE_MULTIPLIER, levels_height + countries_graph_height - 30 * SIZE_MULTIPLIER,
+						countryCountFont, leaderboardFontPaint);
+
+					// Draw graph bar
+					int bar_height = total_height * ((float)count / biggest_size);
+					SkPaint barPaint;
+					barPaint.setColor(SK_ColorWHITE);
+					canvas->drawRect(
+						SkRect::MakeXYWH((float)start_x + 9.0f * SIZE_MULTIPLIER,
+							(float)(levels_height + total_height - bar_height), 36.0f * SIZE_MULTIPLIER, (float)bar_height),
+						barPaint);
+				}
+			}
+			if(draw_timer_graph) {
+				canvas->restore();
 			}
 
 #ifdef RENDER_LINES
@@ -1838,9 +1926,64 @@ int main(int argc, char* argv[]) {
 			// canvas->scale()
 			int players_rendered = 0;
 
+			auto& paths              = level_frames[data_id];
+			auto& level_path_players = path_players[data_id];
+#ifdef RENDER_PLAYER
+			// With the transposed table the frames around player_update come from three slices walked alongside the
+			// ranks instead of one lookup into every path
+			TimeSlice slice_before;
+			TimeSlice slice_current;
+			TimeSlice slice_after;
+			size_t cursor_before  = 0;
+			size_t cursor_current = 0;
+			size_t cursor_after   = 0;
+			if(use_time_major) {
+				auto& table = time_major[data_id];
+				if(player_update != 0) {
+					slice_before = table.slice(player_update - 1);
+				}
+				slice_current = table.slice(player_update);
+				slice_after   = table.slice(player_update + 1);
+			}
+
+			// Ghosts sharing frames player_update and player_update + 1 are at the same spot and move the same way
+			if(share_prefixes) {
+				auto& trie = path_tries[data_id];
+				std::fill(shared_nodes.begin(), shared_nodes.end(), PATH_TRIE_NONE);
+				uint32_t nodes_begin;
+				uint32_t nodes_end;
+				trie.nodes_at(player_update + 1, nodes_begin, nodes_end);
+				for(uint32_t node = nodes_begin; node < nodes_end; node++) {
+					for(auto shared_rank : trie.node_ranks(node)) {
+						shared_nodes[shared_rank] = node;
+					}
+				}
+			}
+#endif
 			for(int rank = 0; rank < ninji_paths_sorted[data_id].size(); rank++) {
-				auto player_num = ninji_paths_sorted[data_id][rank];
-				auto& frames    = ninji_paths[data_id][player_num];
+				auto path_index = ninji_paths_sorted[data_id][rank];
+				auto player_num = level_path_players[path_index];
+				// Compressed and shared paths are only decoded whole where random access is needed, players are drawn
+				// from cursors or trie nodes
+				NinjiPath frames;
+				if(!compress_paths && !share_prefixes) {
+					frames = paths.path(path_index);
+				} else {
+#if defined(RENDER_LINES)
+					bool needs_frames = true;
+#elif defined(RENDER_PLAYER)
+					bool needs_frames = !direction_facing_spline_x_player.contains(player_num);
+#else
+					bool needs_frames = false;
+#endif
+					if(needs_frames && compress_paths) {
+						compressed_paths[data_id].decode(path_index, decoded_path);
+						frames = decoded_path.view();
+					} else if(needs_frames) {
+						path_tries[data_id].decode(rank, decoded_path);
+						frames = decoded_path.view();
+					}
+				}
 #ifdef RENDER_PLAYER
 				// Generate P balloon splines, just in case they're used
 				if (direction_facing_spline_x_player.find(player_num) == direction_facing_spline_x_player.end()) {
@@ -1858,23 +2001,76 @@ int main(int argc, char* argv[]) {
 					direction_facing_spline_y_player[player_num] = direction_facing_spline_y;
 				}
 
-				if(player_update < frames.size() - 1) {
-					auto& player                  = player_info[player_num];
+				NinjiFrame frame_before {};
+				NinjiFrame frame {};
+				NinjiFrame frame_after {};
+				bool has_before;
+				bool has_frame;
+				bool has_after;
+				// Ghosts on a shared route are drawn once by their leader with a count
+				bool draw_sprite = true;
+				int multiplicity = 1;
+				if(use_time_major) {
+					has_before = slice_before.find(rank, cursor_before, frame_before);
+					has_frame  = slice_current.find(rank, cursor_current, frame);
+					has_after  = slice_after.find(rank, cursor_after, frame_after);
+				} else if(compress_paths) {
+					auto& cursor = path_cursors[rank];
+					cursor.seek(player_update);
+					has_before = cursor.before(frame_before);
+					has_frame  = cursor.current(frame);
+					has_after  = cursor.after(frame_after);
+				} else if(share_prefixes) {
+					auto& trie    = path_tries[data_id];
+					uint32_t node = shared_nodes[rank];
+					if(node != PATH_TRIE_NONE) {
+						// Frames either side come straight from the node and its ancestors
+						uint32_t parent = trie.node_parent(node);
+						has_before      = player_update != 0;
+						has_frame       = true;
+						has_after       = true;
+						if(has_before) {
+							frame_before = trie.node_frame(trie.node_parent(parent));
+						}
+						frame       = trie.node_frame(parent);
+						frame_after = trie.node_frame(node);
+						if(rank != trie.node_leader(node)) {
+							draw_sprite = false;
+						} else {
+							multiplicity = trie.node_ranks(node).size();
+						}
+					} else {
+						has_before = player_update != 0 && trie.frame(rank, player_update - 1, frame_before);
+						has_frame  = trie.frame(rank, player_update, frame);
+						has_after  = trie.frame(rank, player_update + 1, frame_after);
+					}
+				} else {
+					has_before = player_update != 0 && player_update - 1 < frames.size();
+					has_frame  = player_update < frames.size();
+					has_after  = player_update + 1 < frames.size();
+					if(has_before) {
+						frame_before = frames[player_update - 1];
+					}
+					if(has_frame) {
+						frame = frames[player_update];
+					}
+					if(has_after) {
+						frame_after = frames[player_update + 1];
+					}
+				}
+
+				if(has_after) {
+					auto& player_name             = player_info.name[player_num];
 					auto& player_local            = player_local_info[data_id][player_num];
-					auto& player_sprites          = player_image[data_id][player_local.charactor];
-					auto& player_mirrored_sprites = player_mirrored_image[data_id][player_local.charactor];
 
-					auto& frame = frames[player_update];
 					// Check that current frame nor next frame are in pipe transition, very glitchy
-					if(!(frame.flags & 0b00000100)
-						&& !((player_update + 1) < frames.size() && frames[player_update + 1].flags & 0b00000100)) {
+					if(!(frame.flags & 0b00000100) && !(has_after && frame_after.flags & 0b00000100)) {
 						ninji_is_subworld[data_id][player_num] = frame.flags & 0b00001000;
 
 						int x;
 						int y;
-						if((player_update + 1) < frames.size()) {
+						if(has_after) {
 							// Lerp
-							auto& frame_after = frames[player_update + 1];
 							int x_before;
 							int y_before;
 							int x_after;
@@ -1915,48 +2111,62 @@ int main(int argc, char* argv[]) {
 
 						if((frame.state == 13 || frame.state == 14) && gamestyle[data_id] == "smw") {
 							// P balloon, specific rotation code using splines
-							auto sprite    = player_sprites[frame.state];
+							int sprite     = ghost_sprite(player_local.charactor, frame.state, false);
 							double delta_x = direction_facing_spline_x_player[player_num](
 								(double)(player_update * NUM_SUBFRAMES + player_update_subframe));
 							double delta_y = direction_facing_spline_y_player[player_num](
 								(double)(player_update * NUM_SUBFRAMES + player_update_subframe));
-							draw_rotated_image(
-								canvas, sprite, atan2(delta_y, -delta_x), SkPoint::Make(x + 16, y + 16 - sprite->height() / 2));
+							if(draw_sprite && sprite >= 0) {
+								// Any rotation stays within the circle around the sprite's corners
+								const SkRect& rect = sprite_atlas.rect(sprite);
+								SkPoint center     = SkPoint::Make(x + 16, y + 16 - (int)rect.height() / 2);
+								float radius       = std::hypot(rect.width(), rect.height()) / 2 + 2;
+								if(track_damage) {
+									damage.add(center.x() - radius, center.y() - radius, center.x() + radius,
+										center.y() + radius);
+								}
+								ghost_batch.add_rotated(sprite, atan2(delta_y, -delta_x), center);
+							}
 						} else {
-							if(player_update != 0 && frames[player_update - 1].x != frames[player_update].x) {
-								player_facing[data_id][player_num]
-									= frames[player_update].x < frames[player_update - 1].x;
+							if(has_before && frame_before.x != frame.x) {
+								player_facing[data_id][player_num] = frame.x < frame_before.x;
 							}
 
-							if(player_facing[data_id][player_num]) {
-								auto sprite = player_mirrored_sprites[frame.state];
-								canvas->drawImage(sprite, x + 16 - sprite->width() / 2, y + 16 - sprite->height() / 2 - sprite->height());
-							} else {
-								auto sprite = player_sprites[frame.state];
-								canvas->drawImage(sprite, x + 16 - sprite->width() / 2, y + 16 - sprite->height() / 2 - sprite->height());
+							// Mirrored sprites are packed separately, a rotation and uniform scale can't flip one
+							int sprite
+								= ghost_sprite(player_local.charactor, frame.state, player_facing[data_id][player_num]);
+							if(!draw_sprite) {
+								// Drawn by the leader of its shared route
+							} else if(sprite >= 0) {
+								int sprite_width  = sprite_atlas.rect(sprite).width();
+								int sprite_height = sprite_atlas.rect(sprite).height();
+								float left        = x + 16 - sprite_width / 2;
+								float top         = y + 16 - sprite_height / 2 - sprite_height;
+								damage_sprite(sprite, left, top);
+								ghost_batch.add(sprite, left, top);
 							}
 						}
 
+						if(multiplicity > 1) {
+							add_ghost_label(fmt::format("x{}", multiplicity), x + 24, y + 16);
+						}
+
 #ifdef DRAW_NAMES
-						canvas->drawSimpleText(player.name.c_str(), player.name.size(), SkTextEncoding::kUTF8, x + 16,
-							y - 4, hoverNameFont, hoverNamePaint);
+						if(draw_sprite) {
+							add_ghost_label(player_name, x + 16, y - 4);
+						}
 #endif
 					}
 
 					players_rendered++;
 
-					// std::cout << "Draw player " << player.name << " at " << (frame.x / 16) << " " << (frame.y / 16)
+					// std::cout << "Draw player " << player_name << " at " << (frame.x / 16) << " " << (frame.y / 16)
 					// << std::endl;
-				} else if(player_update == frames.size() - 1 && player_update_subframe == NUM_SUBFRAMES - 1) {
+				} else if(has_frame && player_update_subframe == NUM_SUBFRAMES - 1) {
 					// Remove from rankings
-					auto size     = level_times[data_id].size();
-					auto& last    = level_times[data_id][size - 1];
-					auto& country = player_info[last.player].country;
-					if(!countries_so_far.contains(country)) {
-						countries_so_far[country] = 1;
-					} else {
-						countries_so_far[country]++;
-					}
+					auto size  = level_times[data_id].size();
+					auto& last = level_times[data_id][size - 1];
+					count_country(player_info.country[last.player]);
 					level_times[data_id].pop_back();
 				}
 #endif
@@ -1987,14 +2197,9 @@ int main(int argc, char* argv[]) {
 
 					if(player_update == frames.size() && player_update_subframe == 0) {
 						// Remove from rankings
-						auto size     = level_times[data_id].size();
-						auto& last    = level_times[data_id][size - 1];
-						auto& country = player_info[last.player].country;
-						if(!countries_so_far.contains(country)) {
-							countries_so_far[country] = 1;
-						} else {
-							countries_so_far[country]++;
-						}
+						auto size  = level_times[data_id].size();
+						auto& last = level_times[data_id][size - 1];
+						count_country(player_info.country[last.player]);
 						level_times[data_id].pop_back();
 					} else {
 						players_rendered++;
@@ -2014,7 +2219,7 @@ int main(int argc, char* argv[]) {
 					}
 
 					for(int i = 0; i < max_update; i++) {
-						auto& frame = frames[i];
+						auto frame = frames[i];
 						int x;
 						int y;
 						bool is_in_subworld = frame.flags & 0b00001000;
@@ -2028,7 +2233,7 @@ int main(int argc, char* argv[]) {
 								+ 120 * SIZE_MULTIPLIER;
 						}
 
-						auto& frame_next = frames[i + 1];
+						auto frame_next = frames[i + 1];
 						int x_next;
 						int y_next;
 						is_in_subworld = frame_next.flags & 0b00001000;
@@ -2050,11 +2255,11 @@ int main(int argc, char* argv[]) {
 					}
 
 					if((player_update + 1) < frames.size()) {
-						auto& frame                            = frames[player_update];
+						auto frame                             = frames[player_update];
 						ninji_is_subworld[data_id][player_num] = frame.flags & 0b00001000;
 
 						// Lerp
-						auto& frame_after = frames[player_update + 1];
+						auto frame_after = frames[player_update + 1];
 						int x_before;
 						int y_before;
 						int x_after;
@@ -2089,9 +2294,60 @@ int main(int argc, char* argv[]) {
 #endif
 			}
 
+			ghost_batch.draw(canvas);
+			for(size_t i = 0; i < num_ghost_labels; i++) {
+				auto& label = ghost_labels[i];
+				canvas->drawSimpleText(label.text.data(), label.text.size(), SkTextEncoding::kUTF8, label.position.x(),
+					label.position.y(), hoverNameFont, hoverNamePaint);
+			}
+			num_ghost_labels = 0;
+
+			if(track_damage && show_damage) {
+				// Outlines are drawn over as well, so the next frame restores them
+				SkPaint damagePaint;
+				damagePaint.setStyle(SkPaint::kStroke_Style);
+				damagePaint.setStrokeWidth(2);
+				damage_rects.clear();
+				damage.restored_rects(damage_rects);
+				damagePaint.setColor(SK_ColorBLUE);
+				for(auto& rect : damage_rects) {
+					canvas->drawRect(SkRect::MakeLTRB(rect.left + 1, rect.top + 1, rect.right - 1, rect.bottom - 1),
+						damagePaint);
+				}
+				size_t num_restored = damage_rects.size();
+				damage.damaged_rects(damage_rects);
+				damagePaint.setColor(SK_ColorRED);
+				for(size_t i = num_restored; i < damage_rects.size(); i++) {
+					auto& rect = damage_rects[i];
+					canvas->drawRect(SkRect::MakeLTRB(rect.left + 3, rect.top + 3, rect.right - 3, rect.bottom - 3),
+						damagePaint);
+				}
+				for(auto& rect : damage_rects) {
+					damage.add(rect.left, rect.top, rect.right, rect.bottom);
+				}
+			}
+
+#ifdef RENDER_VIDEO
+			if(record_frames) {
+				sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+				canvas                   = surface_canvas;
+				if(frame == band_scaling_frame) {
+					std::cout << "Band scaling of frame " << frame << " of " << data_id << ", "
+							  << picture->approximateOpCount() << " draws" << std::endl;
+					report_band_scaling(picture.get(), info, pixelMemory.data(), rowBytes, render_threads, 20);
+				}
+				auto playback_start = std::chrono::steady_clock::now();
+				band_renderer.render(picture.get());
+				playback_seconds
+					+= std::chrono::duration<double>(std::chrono::steady_clock::now() - playback_start).count();
+			}
+#endif
+
 			canvas->flush();
 
 #ifdef RENDER_VIDEO
+			auto draw_end = std::chrono::steady_clock::now();
+			draw_seconds += std::chrono::duration<double>(draw_end - draw_start).count();
 			bool render_this_frame = true;
 #endif
 #ifdef RENDER_LINES
@@ -2170,6 +2426,7 @@ int main(int argc, char* argv[]) {
 				//	stop = true;
 				// }
 			}
+			encode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - draw_end).count();
 #endif
 
 #ifdef RENDER_SCREEN
@@ -2178,6 +2435,21 @@ int main(int argc, char* argv[]) {
 		}
 
 #ifdef RENDER_VIDEO
+		if(frame) {
+			std::cout << "Rendered " << frame << " frames of " << data_id << ", per frame "
+					  << copy_seconds * 1000.0 / frame << "ms copying the static layer (" << compose_seconds * 1000.0
+					  << "ms to draw it), " << draw_seconds * 1000.0 / frame << "ms drawing, "
+					  << encode_seconds * 1000.0 / frame << "ms encoding" << std::endl;
+			if(record_frames) {
+				std::cout << playback_seconds * 1000.0 / frame << "ms of drawing spent playing frames back in "
+						  << band_renderer.num_bands() << " bands" << std::endl;
+			}
+			if(track_damage) {
+				std::cout << "Restored " << 100.0 * restored_pixels / ((uint64_t)frame * width * height)
+						  << "% of each frame from the static layer on average" << std::endl;
+			}
+		}
+
 		encode_frame(oc, codec_context, NULL, pkt, stream);
 
 		av_write_trailer(oc);
@@ -0,0 +1,129 @@
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if(this != &other) {
+		close();
+		mapping      = std::exchange(other.mapping, nullptr);
+		mapping_size = std::exchange(other.mapping_size, 0);
+#ifdef WIN32
+		file_handle    = std::exchange(other.file_handle, nullptr);
+		mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& path) {
+	close();
+
+#ifdef WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!file_mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!view) {
+		CloseHandle(file_mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	file_handle    = file;
+	mapping_handle = file_mapping;
+	mapping        = (const uint8_t*)view;
+	mapping_size   = file_size.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	struct stat file_stat;
+	if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping keeps its own reference to the file
+	::close(fd);
+	if(view == MAP_FAILED) {
+		return false;
+	}
+
+	mapping      = (const uint8_t*)view;
+	mapping_size = file_stat.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::close() {
+	if(!mapping) {
+		return;
+	}
+
+#ifdef WIN32
+	UnmapViewOfFile(mapping);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+	file_handle    = nullptr;
+	mapping_handle = nullptr;
+#else
+	munmap((void*)mapping, mapping_size);
+#endif
+
+	mapping      = nullptr;
+	mapping_size = 0;
+}
+
+void MappedFile::prefetch(size_t offset, size_t size) const {
+	if(!mapping || offset >= mapping_size) {
+		return;
+	}
+	size = std::min(size, mapping_size - offset);
+
+#ifdef WIN32
+	WIN32_MEMORY_RANGE_ENTRY range { (void*)(mapping + offset), size };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// madvise wants a page aligned start
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t aligned   = offset & ~(page_size - 1);
+	madvise((void*)(mapping + aligned), size + offset - aligned, MADV_WILLNEED);
+#endif
+}
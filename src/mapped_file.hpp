@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read only memory mapping of a whole file
+class MappedFile {
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	bool open(const std::string& path);
+	void close();
+
+	// Hints that a range will be read soon so the OS can start paging it in, offset need not be page aligned
+	void prefetch(size_t offset, size_t size) const;
+
+	const uint8_t* data() const {
+		return mapping;
+	}
+
+	size_t size() const {
+		return mapping_size;
+	}
+
+private:
+	const uint8_t* mapping = nullptr;
+	size_t mapping_size    = 0;
+#ifdef WIN32
+	void* file_handle    = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
@@ -0,0 +1,171 @@
+#include "ninji_decoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// Frames reserved up front when the replay size isn't known, so a corrupt frame count can't reserve gigabytes
+constexpr uint32_t NINJI_MAX_RESERVED_FRAMES = 16384;
+
+// Flags with either of these bits set are followed by the unk1 byte after the position
+constexpr uint8_t NINJI_FLAGS_UNK1 = 0b0110;
+
+constexpr uint8_t NINJI_LAYOUT_SIZE    = 0x0F;
+constexpr uint8_t NINJI_LAYOUT_GUESSED = 0x80;
+
+// Frame sizes keyed on the flags nibble and the low 5 bits of unk1, the only ones that change the size. Frames
+// without unk1 have the same size whatever the byte after their position is
+static constexpr std::array<uint8_t, 16 * 32> NINJI_FRAME_LAYOUTS = [] {
+	std::array<uint8_t, 16 * 32> layouts {};
+	for(int flags = 0; flags < 16; flags++) {
+		for(int unk1 = 0; unk1 < 32; unk1++) {
+			uint8_t& layout = layouts[flags << 5 | unk1];
+			if(!(flags & NINJI_FLAGS_UNK1)) {
+				layout = 5;
+			} else if(unk1 & 0b00110) {
+				// Undocumented, taken to be the unk1 byte alone
+				layout = 6 | NINJI_LAYOUT_GUESSED;
+			} else if(unk1 & 0b11000) {
+				layout = 8;
+			} else {
+				layout = 6;
+			}
+		}
+	}
+	return layouts;
+}();
+
+// Layout of a frame with at least NINJI_MAX_FRAME_SIZE bytes readable
+static uint8_t ninji_frame_layout(const uint8_t* frame) {
+	return NINJI_FRAME_LAYOUTS[(frame[0] >> 4) << 5 | (frame[5] & 0x1F)];
+}
+
+// Layout of the frame starting at frame, or 0 if more than available bytes are needed to tell
+static uint8_t ninji_frame_layout(const uint8_t* frame, size_t available) {
+	uint8_t flags = frame[0] >> 4;
+	uint8_t unk1  = 0;
+	if(flags & NINJI_FLAGS_UNK1) {
+		if(available < 6) {
+			return 0;
+		}
+		unk1 = frame[5];
+	}
+	return NINJI_FRAME_LAYOUTS[flags << 5 | (unk1 & 0x1F)];
+}
+
+static NinjiFrame read_ninji_frame(const uint8_t* frame) {
+	uint8_t flags        = frame[0] >> 4;
+	uint8_t player_state = frame[0] & 0x0F;
+	uint16_t x;
+	uint16_t y;
+	memcpy(&x, &frame[1], sizeof(x));
+	memcpy(&y, &frame[3], sizeof(y));
+	return NinjiFrame { player_state, x, y, flags };
+}
+
+const char* ninji_decode_error_name(NinjiDecodeError error) {
+	switch(error) {
+	case NinjiDecodeError::NONE:
+		return "none";
+	case NinjiDecodeError::TRUNCATED_HEADER:
+		return "truncated header";
+	case NinjiDecodeError::FRAME_COUNT_OVERFLOW:
+		return "frame count past the end";
+	case NinjiDecodeError::TRUNCATED_FRAMES:
+		return "truncated frames";
+	}
+	return "unknown";
+}
+
+bool NinjiFrameDecoder::feed(std::span<const uint8_t> data, std::vector<NinjiFrame>& frames) {
+	if(overflowed) {
+		return false;
+	}
+
+	size_t pos = 0;
+
+	if(header_size < NINJI_HEADER_SIZE) {
+		size_t needed = std::min(NINJI_HEADER_SIZE - header_size, data.size());
+		memcpy(&header[header_size], data.data(), needed);
+		header_size += needed;
+		pos += needed;
+
+		if(header_size < NINJI_HEADER_SIZE) {
+			return true;
+		}
+
+		// Big endian
+		uint32_t num_frames = (uint32_t)header[0x10] << 24 | header[0x11] << 16 | header[0x12] << 8 | header[0x13];
+
+		charactor = header[0x14];
+
+		// Ninji's are rendered every 4 frames, 2 is because the frames is always two less than it should be
+		frames_left = ((uint64_t)num_frames + 2) / 4;
+
+		uint32_t reserved = std::min(frames_left, NINJI_MAX_RESERVED_FRAMES);
+		if(replay_size) {
+			if(frames_left > (replay_size - NINJI_HEADER_SIZE) / NINJI_MIN_FRAME_SIZE) {
+				overflowed = true;
+				return false;
+			}
+			reserved = frames_left;
+		}
+		frames.reserve(frames.size() + reserved);
+	}
+
+	while(frames_left && pos < data.size()) {
+		// No frame is longer than NINJI_MAX_FRAME_SIZE, so this many fit in the chunk without checking each one
+		uint32_t batch = pending_size ? 0 : std::min<size_t>((data.size() - pos) / NINJI_MAX_FRAME_SIZE, frames_left);
+		if(batch) {
+			const uint8_t* frame = &data[pos];
+			for(uint32_t i = 0; i < batch; i++) {
+				frames.push_back(read_ninji_frame(frame));
+				// Most frames have no unk1, a predictable branch keeps the table load off their critical path
+				if(!(frame[0] >> 4 & NINJI_FLAGS_UNK1)) {
+					frame += NINJI_MIN_FRAME_SIZE;
+					continue;
+				}
+				uint8_t layout = ninji_frame_layout(frame);
+				guessed += layout >> 7;
+				frame += layout & NINJI_LAYOUT_SIZE;
+			}
+			pos = frame - data.data();
+			frames_left -= batch;
+			continue;
+		}
+
+		// Frame near the end of the chunk, collect it a byte at a time
+		pending[pending_size++] = data[pos++];
+		uint8_t layout          = ninji_frame_layout(pending, pending_size);
+		if(layout && pending_size == (layout & NINJI_LAYOUT_SIZE)) {
+			frames.push_back(read_ninji_frame(pending));
+			guessed += layout >> 7;
+			pending_size = 0;
+			frames_left--;
+		}
+	}
+
+	return true;
+}
+
+NinjiDecodeStatus NinjiFrameDecoder::status() const {
+	NinjiDecodeStatus status;
+	status.guessed_frames = guessed;
+	if(overflowed) {
+		status.error = NinjiDecodeError::FRAME_COUNT_OVERFLOW;
+	} else if(header_size < NINJI_HEADER_SIZE) {
+		status.error = NinjiDecodeError::TRUNCATED_HEADER;
+	} else if(frames_left) {
+		status.error = NinjiDecodeError::TRUNCATED_FRAMES;
+	}
+	return status;
+}
+
+bool decode_ninji_replay(std::span<const uint8_t> replay, uint8_t& charactor, std::vector<NinjiFrame>& frames,
+	NinjiDecodeStatus& status) {
+	NinjiFrameDecoder decoder(replay.size());
+	decoder.feed(replay, frames);
+	charactor = decoder.charactor;
+	status    = decoder.status();
+	return decoder.finished();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// https://github.com/kinnay/Nintendo-File-Formats/wiki/SMM-2-Ninji-Ghosts
+enum NinjiFrameInfo : int8_t {
+	NONE       = -1,
+	DEATH_UNK1 = 10,
+	DOOR       = 11,
+};
+
+struct __attribute__((packed, aligned(8))) NinjiFrame {
+	uint8_t state;
+	uint16_t x;
+	uint16_t y;
+	uint8_t flags;
+	// NinjiFrameInfo info = NinjiFrameInfo::NONE;
+	// uint8_t flags       = 0;
+};
+
+constexpr size_t NINJI_HEADER_SIZE = 0x3C;
+// Frame without the extra unk1 byte
+constexpr size_t NINJI_MIN_FRAME_SIZE = 5;
+// Frame with the extra unk1 byte and the 2 bytes that can follow it
+constexpr size_t NINJI_MAX_FRAME_SIZE = 8;
+
+// Why a replay could not be decoded
+enum class NinjiDecodeError : uint8_t {
+	NONE,
+	// Ended inside the header
+	TRUNCATED_HEADER,
+	// Header claims more frames than the replay has bytes for, only caught up front when the replay size is known
+	FRAME_COUNT_OVERFLOW,
+	// Ended before the last frame
+	TRUNCATED_FRAMES,
+};
+
+constexpr size_t NINJI_DECODE_ERROR_COUNT = 4;
+
+const char* ninji_decode_error_name(NinjiDecodeError error);
+
+struct NinjiDecodeStatus {
+	NinjiDecodeError error = NinjiDecodeError::NONE;
+	// Frames whose unk1 byte has a layout nobody has documented yet, their size is a guess and every frame after the
+	// first of them may be garbage
+	uint32_t guessed_frames = 0;
+};
+
+// Incremental frame decoder, the inflated replay can be fed in chunks of any size and frames are emitted as soon as
+// they are complete. Frame sizes come from a table, and the length is only checked once per run of frames that are
+// sure to fit the chunk
+class NinjiFrameDecoder {
+public:
+	// replay_size is the size of the whole inflated replay, 0 if it isn't known up front
+	NinjiFrameDecoder(size_t replay_size = 0)
+		: replay_size(replay_size) { }
+
+	// Returns false once the replay is known to be malformed, the remaining data is ignored
+	bool feed(std::span<const uint8_t> data, std::vector<NinjiFrame>& frames);
+
+	bool finished() const {
+		return header_size == NINJI_HEADER_SIZE && frames_left == 0;
+	}
+
+	// Decoding so far, a replay that hasn't finished yet counts as truncated
+	NinjiDecodeStatus status() const;
+
+	uint8_t charactor = 0;
+
+private:
+	uint8_t header[NINJI_HEADER_SIZE];
+	size_t header_size   = 0;
+	size_t replay_size   = 0;
+	uint32_t frames_left = 0;
+	uint32_t guessed     = 0;
+	bool overflowed      = false;
+	uint8_t pending[NINJI_MAX_FRAME_SIZE];
+	size_t pending_size = 0;
+};
+
+// Decode the frames of a decompressed ghost, appending them to frames. status says why when it fails
+bool decode_ninji_replay(std::span<const uint8_t> replay, uint8_t& charactor, std::vector<NinjiFrame>& frames,
+	NinjiDecodeStatus& status);
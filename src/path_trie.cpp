@@ -0,0 +1,178 @@
+#include "path_trie.hpp"
+
+#include <algorithm>
+#include <utility>
+
+void PathTrie::build(
+	const LevelFrames& frames, std::span<const uint32_t> rank_paths, std::span<const uint8_t> rank_charactors) {
+	depth_offsets = { 0 };
+	node_parents.clear();
+	node_x.clear();
+	node_y.clear();
+	node_state.clear();
+	node_flags.clear();
+	node_begin.clear();
+	node_count.clear();
+	node_leaders.clear();
+	suffixes = LevelFrames();
+
+	uint32_t num_ranks = rank_paths.size();
+	leaves.assign(num_ranks, PATH_TRIE_NONE);
+	shared_sizes.assign(num_ranks, 0);
+	members.resize(num_ranks);
+	for(uint32_t rank = 0; rank < num_ranks; rank++) {
+		members[rank] = rank;
+	}
+
+	auto offsets = frames.offsets();
+	auto x       = frames.x();
+	auto y       = frames.y();
+	auto state   = frames.state();
+	auto flags   = frames.flags();
+
+	// One frame and the ghost's character as a single comparable value, the character bits are dropped when a node is
+	// made from it
+	auto get_key = [&](uint32_t rank, size_t t) {
+		size_t frame = offsets[rank_paths[rank]] + t;
+		return (uint64_t)rank_charactors[rank] << 48 | (uint64_t)x[frame] << 32 | (uint64_t)y[frame] << 16
+			   | (uint64_t)state[frame] << 8 | flags[frame];
+	};
+
+	// Ranges of members with identical frames so far, split one depth at a time. A range only ever reorders its own
+	// members, so the ranges of shallower nodes stay valid
+	struct Group {
+		uint32_t node;
+		uint32_t begin;
+		uint32_t end;
+	};
+	std::vector<Group> groups { Group { PATH_TRIE_NONE, 0, num_ranks } };
+	std::vector<Group> next_groups;
+	std::vector<std::pair<uint64_t, uint32_t>> keyed;
+	std::vector<uint32_t> left;
+
+	for(size_t t = 0; !groups.empty(); t++) {
+		next_groups.clear();
+		for(auto& group : groups) {
+			keyed.clear();
+			left.clear();
+			for(uint32_t i = group.begin; i < group.end; i++) {
+				uint32_t rank = members[i];
+				if(frames.path(rank_paths[rank]).size() > t) {
+					keyed.emplace_back(get_key(rank, t), rank);
+				} else {
+					left.push_back(rank);
+				}
+			}
+			std::sort(keyed.begin(), keyed.end());
+
+			uint32_t write = group.begin;
+			for(size_t i = 0; i < keyed.size();) {
+				size_t run_end = i + 1;
+				while(run_end < keyed.size() && keyed[run_end].first == keyed[i].first) {
+					run_end++;
+				}
+
+				if(run_end - i > 1) {
+					uint64_t key  = keyed[i].first;
+					uint32_t node = node_parents.size();
+					next_groups.push_back(Group { node, write, (uint32_t)(write + run_end - i) });
+					node_parents.push_back(group.node);
+					node_x.push_back(key >> 32);
+					node_y.push_back(key >> 16);
+					node_state.push_back(key >> 8);
+					node_flags.push_back(key);
+					node_begin.push_back(write);
+					node_count.push_back(run_end - i);
+					node_leaders.push_back(keyed[i].second);
+					for(; i < run_end; i++) {
+						members[write++] = keyed[i].second;
+					}
+				} else {
+					left.push_back(keyed[i].second);
+					i = run_end;
+				}
+			}
+
+			// Ghosts that ended or went their own way share frames up to here
+			for(auto rank : left) {
+				leaves[rank]       = group.node;
+				shared_sizes[rank] = t;
+			}
+			std::copy(left.begin(), left.end(), members.begin() + write);
+		}
+
+		depth_offsets.push_back(node_parents.size());
+		std::swap(groups, next_groups);
+	}
+
+	std::vector<NinjiFrame> suffix;
+	for(uint32_t rank = 0; rank < num_ranks; rank++) {
+		auto path = frames.path(rank_paths[rank]);
+		suffix.clear();
+		for(size_t t = shared_sizes[rank]; t < path.size(); t++) {
+			suffix.push_back(path[t]);
+		}
+		suffixes.add_path();
+		suffixes.append(suffix);
+	}
+}
+
+void PathTrie::nodes_at(size_t t, uint32_t& begin, uint32_t& end) const {
+	if(t + 1 >= depth_offsets.size()) {
+		begin = 0;
+		end   = 0;
+		return;
+	}
+	begin = depth_offsets[t];
+	end   = depth_offsets[t + 1];
+}
+
+bool PathTrie::frame(uint32_t rank, size_t t, NinjiFrame& frame) const {
+	uint32_t shared_size = shared_sizes[rank];
+	if(t >= shared_size) {
+		auto suffix = suffixes.path(rank);
+		if(t - shared_size >= suffix.size()) {
+			return false;
+		}
+		frame = suffix[t - shared_size];
+		return true;
+	}
+
+	uint32_t node = leaves[rank];
+	for(size_t depth = shared_size - 1; depth > t; depth--) {
+		node = node_parents[node];
+	}
+	frame = node_frame(node);
+	return true;
+}
+
+void PathTrie::decode(uint32_t rank, DecodedPath& decoded) const {
+	uint32_t size = path_size(rank);
+	decoded.x.resize(size);
+	decoded.y.resize(size);
+	decoded.state.resize(size);
+	decoded.flags.resize(size);
+
+	// Shared frames come out deepest first
+	uint32_t node = leaves[rank];
+	for(size_t t = shared_sizes[rank]; t > 0; t--) {
+		decoded.x[t - 1]     = node_x[node];
+		decoded.y[t - 1]     = node_y[node];
+		decoded.state[t - 1] = node_state[node];
+		decoded.flags[t - 1] = node_flags[node];
+		node                 = node_parents[node];
+	}
+
+	auto suffix = suffixes.path(rank);
+	std::copy(suffix.x.begin(), suffix.x.end(), decoded.x.begin() + shared_sizes[rank]);
+	std::copy(suffix.y.begin(), suffix.y.end(), decoded.y.begin() + shared_sizes[rank]);
+	std::copy(suffix.state.begin(), suffix.state.end(), decoded.state.begin() + shared_sizes[rank]);
+	std::copy(suffix.flags.begin(), suffix.flags.end(), decoded.flags.begin() + shared_sizes[rank]);
+}
+
+size_t PathTrie::size_bytes() const {
+	size_t node_bytes = node_parents.size() * (sizeof(uint32_t) * 4 + sizeof(uint16_t) * 2 + sizeof(uint8_t) * 2);
+	size_t rank_bytes = members.size() * sizeof(uint32_t) * 3;
+	return depth_offsets.size() * sizeof(uint32_t) + node_bytes + rank_bytes + suffixes.offsets().size_bytes()
+		   + suffixes.num_frames() * 6;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "frame_store.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+constexpr uint32_t PATH_TRIE_NONE = UINT32_MAX;
+
+// Ghosts whose frames 0 through t are identical share one node at depth t, so an opening taken frame for frame by
+// many ghosts is stored once. Nodes of a depth are stored together and the ghosts of a node are one contiguous range,
+// so the ghosts still sharing a route at a frame are known without looking at their frames. Whatever follows a
+// ghost's last shared frame is kept privately
+class PathTrie {
+public:
+	// Ghosts are ranks, rank_paths[rank] being the path drawn at that rank. Ghosts drawn with a different character,
+	// rank_charactors[rank], never share a node since the leader's sprite is drawn for all of them
+	void build(
+		const LevelFrames& frames, std::span<const uint32_t> rank_paths, std::span<const uint8_t> rank_charactors);
+
+	// Nodes at depth t are [begin, end), empty past the deepest shared frame
+	void nodes_at(size_t t, uint32_t& begin, uint32_t& end) const;
+
+	NinjiFrame node_frame(uint32_t node) const {
+		return NinjiFrame { node_state[node], node_x[node], node_y[node], node_flags[node] };
+	}
+
+	// PATH_TRIE_NONE at depth 0
+	uint32_t node_parent(uint32_t node) const {
+		return node_parents[node];
+	}
+
+	std::span<const uint32_t> node_ranks(uint32_t node) const {
+		return std::span<const uint32_t>(members).subspan(node_begin[node], node_count[node]);
+	}
+
+	// Lowest rank on the node, the one that draws it
+	uint32_t node_leader(uint32_t node) const {
+		return node_leaders[node];
+	}
+
+	uint32_t path_size(uint32_t rank) const {
+		return shared_sizes[rank] + suffixes.path(rank).size();
+	}
+
+	// Frame t of a ghost, false past its end. Walks up from the ghost's last shared node, so it's only cheap near
+	// where the ghost leaves the trie
+	bool frame(uint32_t rank, size_t t, NinjiFrame& frame) const;
+
+	void decode(uint32_t rank, DecodedPath& decoded) const;
+
+	size_t size_bytes() const;
+
+private:
+	// Nodes at depth t are [depth_offsets[t], depth_offsets[t + 1])
+	std::vector<uint32_t> depth_offsets;
+	std::vector<uint32_t> node_parents;
+	std::vector<uint16_t> node_x;
+	std::vector<uint16_t> node_y;
+	std::vector<uint8_t> node_state;
+	std::vector<uint8_t> node_flags;
+	// Node i's ghosts are members[node_begin[i], node_begin[i] + node_count[i])
+	std::vector<uint32_t> node_begin;
+	std::vector<uint32_t> node_count;
+	std::vector<uint32_t> node_leaders;
+	std::vector<uint32_t> members;
+
+	// Per rank, the deepest node shared with another ghost and how many frames that covers
+	std::vector<uint32_t> leaves;
+	std::vector<uint32_t> shared_sizes;
+	// Path i holds the frames of rank i after its shared ones
+	LevelFrames suffixes;
+};
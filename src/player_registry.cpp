@@ -0,0 +1,83 @@
+#include "player_registry.hpp"
+
+#include <cstring>
+
+// Slots start here and double whenever the table would pass 50% full
+constexpr size_t PLAYER_REGISTRY_MIN_SLOTS = 1024;
+
+PlayerRegistry::PlayerRegistry()
+	: pid_offsets(1, 0)
+	, slot_ids(PLAYER_REGISTRY_MIN_SLOTS, 0)
+	, slot_hashes(PLAYER_REGISTRY_MIN_SLOTS, 0) { }
+
+// Pids are short fixed width strings (16 hex digits), so they're mixed 8 bytes at a time instead of byte by byte
+uint64_t PlayerRegistry::hash(std::string_view pid) {
+	const uint64_t multiplier = 0x9E3779B97F4A7C15;
+	uint64_t h                = pid.size() * multiplier;
+
+	size_t i = 0;
+	for(; i + 8 <= pid.size(); i += 8) {
+		uint64_t word;
+		memcpy(&word, pid.data() + i, sizeof(word));
+		h = (h ^ word) * multiplier;
+		h ^= h >> 32;
+	}
+	if(i < pid.size()) {
+		uint64_t word = 0;
+		memcpy(&word, pid.data() + i, pid.size() - i);
+		h = (h ^ word) * multiplier;
+		h ^= h >> 32;
+	}
+
+	return h;
+}
+
+void PlayerRegistry::reserve(size_t num_players, size_t average_pid_size) {
+	arena.reserve(num_players * average_pid_size);
+	pid_offsets.reserve(num_players + 1);
+	while(slot_ids.size() < num_players * 2) {
+		grow();
+	}
+}
+
+void PlayerRegistry::grow() {
+	size_t num_slots = slot_ids.size() * 2;
+	slot_ids.assign(num_slots, 0);
+	slot_hashes.assign(num_slots, 0);
+
+	size_t mask = num_slots - 1;
+	for(uint32_t id = 0; id < size(); id++) {
+		uint64_t h  = hash(pid(id));
+		size_t slot = h & mask;
+		while(slot_ids[slot]) {
+			slot = (slot + 1) & mask;
+		}
+		slot_ids[slot]    = id + 1;
+		slot_hashes[slot] = h >> 32;
+	}
+}
+
+uint32_t PlayerRegistry::intern(std::string_view pid_to_intern) {
+	uint64_t h  = hash(pid_to_intern);
+	size_t mask = slot_ids.size() - 1;
+	size_t slot = h & mask;
+	for(; slot_ids[slot]; slot = (slot + 1) & mask) {
+		if(slot_hashes[slot] == (uint32_t)(h >> 32) && pid(slot_ids[slot] - 1) == pid_to_intern) {
+			return slot_ids[slot] - 1;
+		}
+	}
+
+	uint32_t id = size();
+	arena.insert(arena.end(), pid_to_intern.begin(), pid_to_intern.end());
+	pid_offsets.push_back(arena.size());
+
+	if((size_t)(id + 1) * 2 > slot_ids.size()) {
+		// Rehashes every pid, including the new one
+		grow();
+	} else {
+		slot_ids[slot]    = id + 1;
+		slot_hashes[slot] = h >> 32;
+	}
+
+	return id;
+}
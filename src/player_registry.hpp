@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Interns pids and hands out dense player ids starting at 0. Pids are stored back to back in one arena and found
+// through an open addressing table of ids, so a player costs its pid bytes plus a few words instead of a map node
+// and a heap string per lookup direction. Per player attributes are meant to live in arrays indexed by the id
+class PlayerRegistry {
+public:
+	PlayerRegistry();
+
+	// Returns the id of pid, adding it if it hasn't been seen before
+	uint32_t intern(std::string_view pid);
+
+	std::string_view pid(uint32_t id) const {
+		return std::string_view(arena.data() + pid_offsets[id], pid_offsets[id + 1] - pid_offsets[id]);
+	}
+
+	uint32_t size() const {
+		return pid_offsets.size() - 1;
+	}
+
+	// Sizes the table and arena for num_players in total, so interning that many never rehashes
+	void reserve(size_t num_players, size_t average_pid_size = 16);
+
+private:
+	static uint64_t hash(std::string_view pid);
+	void grow();
+
+	std::vector<char> arena;
+	// size() + 1 entries, pid i is arena[pid_offsets[i], pid_offsets[i + 1])
+	std::vector<uint32_t> pid_offsets;
+	// Power of two sized, id + 1 or 0 when empty, the hash is kept next to it so probing rarely touches the arena
+	std::vector<uint32_t> slot_ids;
+	std::vector<uint32_t> slot_hashes;
+};
@@ -0,0 +1,164 @@
+#include "replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <zlib.h>
+
+// Per thread inflate state, the z_stream and output buffer are reused for every replay so inflating does no
+// allocation once warmed up
+struct GzipInflater {
+	z_stream strm {};
+	bool initialized = false;
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t capacity = 0;
+
+	~GzipInflater() {
+		if(initialized) {
+			inflateEnd(&strm);
+		}
+	}
+
+	void reserve(size_t size) {
+		if(size > capacity) {
+			// Not value initialized, every byte handed out is written by inflate first
+			std::unique_ptr<uint8_t[]> new_buffer(new uint8_t[size]);
+			if(strm.total_out) {
+				memcpy(new_buffer.get(), buffer.get(), strm.total_out);
+			}
+			buffer   = std::move(new_buffer);
+			capacity = size;
+		}
+	}
+};
+
+// Deflate can't expand input by more than about 1032 times, an ISIZE past that is corrupt
+constexpr size_t GZIP_MAX_RATIO = 1032;
+// Most the ISIZE trailer is trusted with up front, bigger replays grow the buffer as they inflate
+constexpr size_t GZIP_MAX_INITIAL_RESERVE = 64 * 1024 * 1024;
+
+bool gzip_decompress(const uint8_t* input, size_t input_size, std::span<const uint8_t>& output) {
+	thread_local GzipInflater inflater;
+	z_stream& strm = inflater.strm;
+
+	if(!inflater.initialized) {
+		if(inflateInit2(&strm, (32 + MAX_WBITS)) != Z_OK) {
+			return false;
+		}
+		inflater.initialized = true;
+	} else if(inflateReset(&strm) != Z_OK) {
+		return false;
+	}
+
+	// Last 4 bytes of a gzip member are the uncompressed size mod 2^32, replays are far smaller than that
+	size_t expected_size = input_size;
+	if(input_size >= 18 && input[0] == 0x1F && input[1] == 0x8B) {
+		uint32_t isize = input[input_size - 4] | (input[input_size - 3] << 8) | (input[input_size - 2] << 16)
+						 | ((uint32_t)input[input_size - 1] << 24);
+		// Unchecked, a corrupt trailer must not reserve gigabytes
+		expected_size = std::min({ (size_t)isize, input_size * GZIP_MAX_RATIO, GZIP_MAX_INITIAL_RESERVE });
+	}
+	// One extra byte so the end of the stream is reached without a second call when ISIZE is exact
+	inflater.reserve(expected_size + 1);
+
+	strm.next_in  = (Bytef*)input;
+	strm.avail_in = input_size;
+
+	while(true) {
+		strm.next_out  = inflater.buffer.get() + strm.total_out;
+		strm.avail_out = inflater.capacity - strm.total_out;
+
+		int err = inflate(&strm, Z_FINISH);
+		if(err == Z_STREAM_END) {
+			break;
+		} else if((err == Z_OK || err == Z_BUF_ERROR) && strm.avail_out == 0) {
+			// ISIZE lied (truncated or multi member stream), fall back to growing
+			inflater.reserve(inflater.capacity * 2);
+		} else {
+			return false;
+		}
+	}
+
+	output = std::span<const uint8_t>(inflater.buffer.get(), strm.total_out);
+	return true;
+}
+
+void toLittleEndian(uint32_t& ui) {
+	ui = (ui >> 24) | ((ui << 8) & 0x00FF0000) | ((ui >> 8) & 0x0000FF00) | (ui << 24);
+}
+
+void toLittleEndianShort(uint16_t& ui) {
+	ui = (ui >> 8) | (ui << 8);
+}
+
+// Fixed windows used while streaming, peak memory per replay in flight is two of these
+constexpr size_t STREAM_WINDOW_SIZE = 16384;
+
+struct StreamInflater {
+	z_stream strm {};
+	bool initialized = false;
+	uint8_t in[STREAM_WINDOW_SIZE];
+	uint8_t out[STREAM_WINDOW_SIZE];
+
+	~StreamInflater() {
+		if(initialized) {
+			inflateEnd(&strm);
+		}
+	}
+};
+
+bool stream_ninji_replay(sqlite3_blob* blob, uint8_t& charactor, std::vector<NinjiFrame>& frames,
+	size_t& inflated_size, NinjiDecodeStatus& status) {
+	thread_local std::unique_ptr<StreamInflater> inflater(new StreamInflater());
+	z_stream& strm = inflater->strm;
+
+	if(!inflater->initialized) {
+		if(inflateInit2(&strm, (32 + MAX_WBITS)) != Z_OK) {
+			return false;
+		}
+		inflater->initialized = true;
+	} else if(inflateReset(&strm) != Z_OK) {
+		return false;
+	}
+
+	strm.avail_in = 0;
+	inflated_size = 0;
+
+	int blob_size   = sqlite3_blob_bytes(blob);
+	int blob_offset = 0;
+	NinjiFrameDecoder decoder;
+	while(!decoder.finished()) {
+		if(strm.avail_in == 0) {
+			if(blob_offset == blob_size) {
+				// Ran out of replay before the last frame
+				break;
+			}
+
+			int chunk_size = std::min((int)STREAM_WINDOW_SIZE, blob_size - blob_offset);
+			if(sqlite3_blob_read(blob, inflater->in, chunk_size, blob_offset) != SQLITE_OK) {
+				return false;
+			}
+			blob_offset += chunk_size;
+			strm.next_in  = inflater->in;
+			strm.avail_in = chunk_size;
+		}
+
+		strm.next_out  = inflater->out;
+		strm.avail_out = STREAM_WINDOW_SIZE;
+
+		int err = inflate(&strm, Z_NO_FLUSH);
+		if(err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+			return false;
+		}
+
+		size_t produced = STREAM_WINDOW_SIZE - strm.avail_out;
+		inflated_size += produced;
+		if(!decoder.feed(std::span<const uint8_t>(inflater->out, produced), frames) || err == Z_STREAM_END) {
+			break;
+		}
+	}
+
+	charactor = decoder.charactor;
+	status    = decoder.status();
+	return decoder.finished();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ninji_decoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <sqlite3.h>
+#include <vector>
+
+// Inflates a gzip or zlib stream into a buffer owned by the calling thread. output stays valid until the next call on
+// the same thread
+bool gzip_decompress(const uint8_t* input, size_t input_size, std::span<const uint8_t>& output);
+
+void toLittleEndian(uint32_t& ui);
+void toLittleEndianShort(uint16_t& ui);
+
+// Inflate and decode a ghost straight out of an open blob handle a window at a time, without ever holding the whole
+// compressed or inflated replay. status is left as it was when reading or inflating failed
+bool stream_ninji_replay(sqlite3_blob* blob, uint8_t& charactor, std::vector<NinjiFrame>& frames,
+	size_t& inflated_size, NinjiDecodeStatus& status);
@@ -0,0 +1,236 @@
+#include "replay_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Layout: header, player records, time records, path offsets, then x, y, state and flags of every frame, then pid
+// characters. Every section is naturally aligned so the frame arrays can be used in place
+constexpr uint64_t REPLAY_CACHE_MAGIC   = 0x3143524A4E494E; // "NINJRC1"
+constexpr uint32_t REPLAY_CACHE_VERSION = 3; // Only each player's best run since version 3
+
+struct ReplayCacheHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t num_players;
+	uint64_t num_times;
+	uint64_t num_frames;
+	uint64_t pids_size;
+	ReplayCacheSignature signature;
+};
+
+struct ReplayCachePlayerRecord {
+	uint64_t pid_offset;
+	int32_t time;
+	uint16_t pid_size;
+	uint8_t charactor;
+	uint8_t padding;
+};
+
+static_assert(sizeof(ReplayCacheHeader) % 8 == 0);
+static_assert(sizeof(ReplayCachePlayerRecord) % 8 == 0);
+static_assert(sizeof(ReplayCacheTime) == 8);
+
+// Section starts, in the order they appear in the file
+struct ReplayCacheSections {
+	size_t records;
+	size_t times;
+	size_t offsets;
+	size_t x;
+	size_t y;
+	size_t state;
+	size_t flags;
+	size_t pids;
+	size_t end;
+};
+
+static ReplayCacheSections get_replay_cache_sections(const ReplayCacheHeader& header) {
+	ReplayCacheSections sections;
+	sections.records = sizeof(ReplayCacheHeader);
+	sections.times   = sections.records + header.num_players * sizeof(ReplayCachePlayerRecord);
+	sections.offsets = sections.times + header.num_times * sizeof(ReplayCacheTime);
+	sections.x       = sections.offsets + (header.num_players + 1) * sizeof(uint32_t);
+	sections.y       = sections.x + header.num_frames * sizeof(uint16_t);
+	sections.state   = sections.y + header.num_frames * sizeof(uint16_t);
+	sections.flags   = sections.state + header.num_frames;
+	sections.pids    = sections.flags + header.num_frames;
+	sections.end     = sections.pids + header.pids_size;
+	return sections;
+}
+
+bool get_replay_cache_signature(sqlite3* db, const std::string& db_path, ReplayCacheSignature& signature) {
+	std::error_code ec;
+	signature.db_size = std::filesystem::file_size(db_path, ec);
+	if(ec) {
+		return false;
+	}
+	signature.db_mtime = std::filesystem::last_write_time(db_path, ec).time_since_epoch().count();
+	if(ec) {
+		return false;
+	}
+
+	// Rows are only ever appended to the dump, so the largest rowid changes with every import
+	sqlite3_stmt* res;
+	if(sqlite3_prepare_v2(db, "SELECT MAX(rowid) FROM ninji", -1, &res, 0) != SQLITE_OK) {
+		return false;
+	}
+	bool found = sqlite3_step(res) == SQLITE_ROW;
+	if(found) {
+		signature.max_rowid = sqlite3_column_int64(res, 0);
+	}
+	sqlite3_finalize(res);
+	return found;
+}
+
+std::string get_replay_cache_path(const std::string& cache_dir, int data_id) {
+	return cache_dir + "/" + std::to_string(data_id) + ".bin";
+}
+
+bool write_replay_cache(const std::string& path, const ReplayCacheSignature& signature,
+	const std::vector<ReplayCachePlayer>& players, const std::vector<ReplayCacheTime>& times, const LevelFrames& frames) {
+	if(frames.num_paths() != players.size()) {
+		return false;
+	}
+
+	ReplayCacheHeader header {};
+	header.magic       = REPLAY_CACHE_MAGIC;
+	header.version     = REPLAY_CACHE_VERSION;
+	header.num_players = players.size();
+	header.num_times   = times.size();
+	header.num_frames  = frames.num_frames();
+	header.signature   = signature;
+
+	std::vector<ReplayCachePlayerRecord> records;
+	records.reserve(players.size());
+	for(auto& player : players) {
+		ReplayCachePlayerRecord record {};
+		record.pid_offset = header.pids_size;
+		record.time       = player.time;
+		record.pid_size   = player.pid.size();
+		record.charactor  = player.charactor;
+		records.push_back(record);
+
+		header.pids_size += player.pid.size();
+	}
+
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+	std::string temp_path = path + ".tmp";
+	std::ofstream cache_file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!cache_file) {
+		return false;
+	}
+
+	cache_file.write((const char*)&header, sizeof(header));
+	cache_file.write((const char*)records.data(), records.size() * sizeof(ReplayCachePlayerRecord));
+	cache_file.write((const char*)times.data(), times.size() * sizeof(ReplayCacheTime));
+	cache_file.write((const char*)frames.offsets().data(), frames.offsets().size_bytes());
+	cache_file.write((const char*)frames.x().data(), frames.x().size_bytes());
+	cache_file.write((const char*)frames.y().data(), frames.y().size_bytes());
+	cache_file.write((const char*)frames.state().data(), frames.state().size_bytes());
+	cache_file.write((const char*)frames.flags().data(), frames.flags().size_bytes());
+	for(auto& player : players) {
+		cache_file.write(player.pid.data(), player.pid.size());
+	}
+	cache_file.close();
+
+	if(!cache_file) {
+		std::filesystem::remove(temp_path);
+		return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(temp_path, path, ec);
+	return !ec;
+}
+
+bool ReplayCache::open(const std::string& path, const ReplayCacheSignature& signature) {
+	if(!file.open(path)) {
+		return false;
+	}
+
+	if(file.size() < sizeof(ReplayCacheHeader)) {
+		file.close();
+		return false;
+	}
+
+	auto header = (const ReplayCacheHeader*)file.data();
+	if(header->magic != REPLAY_CACHE_MAGIC || header->version != REPLAY_CACHE_VERSION
+		|| memcmp(&header->signature, &signature, sizeof(signature)) != 0) {
+		file.close();
+		return false;
+	}
+
+	// Counts are bounded by the file size first so computing the section offsets can't overflow
+	if(header->num_times > file.size() || header->num_frames > file.size() || header->pids_size > file.size()
+		|| file.size() != get_replay_cache_sections(*header).end) {
+		file.close();
+		return false;
+	}
+
+	// Offsets index straight into the frame arrays, a corrupt one must not get that far
+	auto offsets = (const uint32_t*)(file.data() + get_replay_cache_sections(*header).offsets);
+	if(offsets[0] != 0 || offsets[header->num_players] != header->num_frames) {
+		file.close();
+		return false;
+	}
+	for(uint32_t i = 0; i < header->num_players; i++) {
+		if(offsets[i] > offsets[i + 1]) {
+			file.close();
+			return false;
+		}
+	}
+
+	// Same for the pids records point into and the players times refer to
+	auto sections = get_replay_cache_sections(*header);
+	auto records  = (const ReplayCachePlayerRecord*)(file.data() + sections.records);
+	for(uint32_t i = 0; i < header->num_players; i++) {
+		if(records[i].pid_offset > header->pids_size
+			|| records[i].pid_size > header->pids_size - records[i].pid_offset) {
+			file.close();
+			return false;
+		}
+	}
+	auto times = (const ReplayCacheTime*)(file.data() + sections.times);
+	for(uint64_t i = 0; i < header->num_times; i++) {
+		if(times[i].player >= header->num_players) {
+			file.close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t ReplayCache::num_players() const {
+	return ((const ReplayCacheHeader*)file.data())->num_players;
+}
+
+ReplayCachePlayer ReplayCache::player(uint32_t index) const {
+	auto header   = (const ReplayCacheHeader*)file.data();
+	auto sections = get_replay_cache_sections(*header);
+	auto records  = (const ReplayCachePlayerRecord*)(file.data() + sections.records);
+	auto pids     = (const char*)(file.data() + sections.pids);
+
+	auto& record = records[index];
+	return ReplayCachePlayer {
+		std::string_view(pids + record.pid_offset, record.pid_size),
+		record.charactor,
+		record.time,
+	};
+}
+
+std::span<const ReplayCacheTime> ReplayCache::times() const {
+	auto header = (const ReplayCacheHeader*)file.data();
+	auto times  = (const ReplayCacheTime*)(file.data() + get_replay_cache_sections(*header).times);
+	return std::span<const ReplayCacheTime>(times, header->num_times);
+}
+
+void ReplayCache::view_frames(LevelFrames& frames) const {
+	auto header   = (const ReplayCacheHeader*)file.data();
+	auto sections = get_replay_cache_sections(*header);
+	frames.view(std::span<const uint32_t>((const uint32_t*)(file.data() + sections.offsets), header->num_players + 1),
+		std::span<const uint16_t>((const uint16_t*)(file.data() + sections.x), header->num_frames),
+		std::span<const uint16_t>((const uint16_t*)(file.data() + sections.y), header->num_frames),
+		std::span<const uint8_t>(file.data() + sections.state, header->num_frames),
+		std::span<const uint8_t>(file.data() + sections.flags, header->num_frames));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "frame_store.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <span>
+#include <sqlite3.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Identifies the state of the source database, a cache written against a different signature is stale
+struct ReplayCacheSignature {
+	uint64_t db_size;
+	int64_t db_mtime;
+	int64_t max_rowid;
+};
+
+// One row of the level, player is an index into the players of the same cache
+struct ReplayCacheTime {
+	uint32_t player;
+	int32_t time;
+};
+
+// Player i owns path i of the level's frames
+struct ReplayCachePlayer {
+	std::string_view pid;
+	uint8_t charactor;
+	int time;
+};
+
+bool get_replay_cache_signature(sqlite3* db, const std::string& db_path, ReplayCacheSignature& signature);
+
+std::string get_replay_cache_path(const std::string& cache_dir, int data_id);
+
+// Writes to a temporary file first so a crashed run never leaves a truncated cache behind
+bool write_replay_cache(const std::string& path, const ReplayCacheSignature& signature,
+	const std::vector<ReplayCachePlayer>& players, const std::vector<ReplayCacheTime>& times, const LevelFrames& frames);
+
+// Preprocessed replays of one level, frames are served straight out of the mapping
+class ReplayCache {
+public:
+	// Fails if the file is missing, malformed or was built against a different signature
+	bool open(const std::string& path, const ReplayCacheSignature& signature);
+
+	uint32_t num_players() const;
+	ReplayCachePlayer player(uint32_t index) const;
+	std::span<const ReplayCacheTime> times() const;
+	// Points frames at the arrays in the mapping, valid as long as the cache stays open
+	void view_frames(LevelFrames& frames) const;
+
+private:
+	MappedFile file;
+};
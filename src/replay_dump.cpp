@@ -0,0 +1,67 @@
+#include "replay_dump.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <tuple>
+
+constexpr uint64_t REPLAY_DUMP_MAGIC   = 0x31504D444A4E494E; // "NINJDMP1"
+constexpr uint32_t REPLAY_DUMP_VERSION = 1;
+
+struct ReplayDumpHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t num_entries;
+};
+
+struct ReplayDumpIndexEntry {
+	int32_t data_id;
+	uint32_t pid_size;
+	uint64_t pid_offset;
+	uint64_t replay_offset;
+	uint64_t replay_size;
+};
+
+void ReplayDump::select(const std::string& pid) {
+	pids.insert(pid);
+}
+
+void ReplayDump::add(int data_id, const std::string& pid, std::span<const uint8_t> replay) {
+	std::lock_guard<std::mutex> lock(entries_mutex);
+	entries.push_back(Entry { data_id, pid, std::vector<uint8_t>(replay.begin(), replay.end()) });
+}
+
+bool ReplayDump::write(const std::string& path) {
+	std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+		return std::tie(lhs.data_id, lhs.pid, lhs.replay) < std::tie(rhs.data_id, rhs.pid, rhs.replay);
+	});
+
+	ReplayDumpHeader header { REPLAY_DUMP_MAGIC, REPLAY_DUMP_VERSION, (uint32_t)entries.size() };
+
+	uint64_t pid_offset    = sizeof(ReplayDumpHeader) + entries.size() * sizeof(ReplayDumpIndexEntry);
+	uint64_t replay_offset = pid_offset;
+	for(auto& entry : entries) {
+		replay_offset += entry.pid.size();
+	}
+
+	std::vector<ReplayDumpIndexEntry> index;
+	index.reserve(entries.size());
+	for(auto& entry : entries) {
+		index.push_back(ReplayDumpIndexEntry {
+			entry.data_id, (uint32_t)entry.pid.size(), pid_offset, replay_offset, entry.replay.size() });
+		pid_offset += entry.pid.size();
+		replay_offset += entry.replay.size();
+	}
+
+	std::ofstream dump_file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	dump_file.write((const char*)&header, sizeof(header));
+	dump_file.write((const char*)index.data(), index.size() * sizeof(ReplayDumpIndexEntry));
+	for(auto& entry : entries) {
+		dump_file.write(entry.pid.data(), entry.pid.size());
+	}
+	for(auto& entry : entries) {
+		dump_file.write((const char*)entry.replay.data(), entry.replay.size());
+	}
+	dump_file.close();
+
+	return (bool)dump_file;
+}
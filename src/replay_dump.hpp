@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Collects the decompressed replays of selected pids for debugging the ghost format, written out as one archive:
+//   header      magic "NINJDMP1", version, number of entries
+//   index       per entry data_id, pid offset and size, replay offset and size, offsets are from the file start
+//   pids        pid characters
+//   replays     decompressed replays back to back
+class ReplayDump {
+public:
+	void select(const std::string& pid);
+
+	bool empty() const {
+		return pids.empty();
+	}
+
+	bool wants(const std::string& pid) const {
+		return pids.count(pid);
+	}
+
+	// Safe to call from any ingest worker, the replay is copied
+	void add(int data_id, const std::string& pid, std::span<const uint8_t> replay);
+
+	size_t size() const {
+		return entries.size();
+	}
+
+	// Entries are sorted by data_id, pid and contents so the archive is the same no matter which worker dumped what
+	bool write(const std::string& path);
+
+private:
+	struct Entry {
+		int data_id;
+		std::string pid;
+		std::vector<uint8_t> replay;
+	};
+
+	std::unordered_set<std::string> pids;
+	std::mutex entries_mutex;
+	std::vector<Entry> entries;
+};
@@ -0,0 +1,96 @@
+#include "sprite_atlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <core/SkSurface.h>
+#include <numeric>
+
+// Transparent pixels between sprites, so sampling near the edge of a rotated sprite never picks up its neighbour
+constexpr int SPRITE_ATLAS_PADDING = 2;
+
+int SpriteAtlas::add(const sk_sp<SkImage>& image) {
+	if(!image) {
+		return -1;
+	}
+	images.push_back(image);
+	rects.push_back(SkRect::MakeWH(image->width(), image->height()));
+	return rects.size() - 1;
+}
+
+bool SpriteAtlas::build() {
+	if(images.empty()) {
+		atlas = nullptr;
+		return true;
+	}
+
+	// Shelves of sprites sorted tallest first, about as wide as the atlas is tall
+	std::vector<int> order(images.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return images[a]->height() > images[b]->height(); });
+
+	int64_t area  = 0;
+	int max_width = 0;
+	for(auto& image : images) {
+		area += (int64_t)(image->width() + SPRITE_ATLAS_PADDING) * (image->height() + SPRITE_ATLAS_PADDING);
+		max_width = std::max(max_width, image->width() + SPRITE_ATLAS_PADDING * 2);
+	}
+	int width = std::max(max_width, (int)std::sqrt((double)area) + SPRITE_ATLAS_PADDING);
+
+	int x            = SPRITE_ATLAS_PADDING;
+	int y            = SPRITE_ATLAS_PADDING;
+	int shelf_height = 0;
+	for(int id : order) {
+		auto& image = images[id];
+		if(x + image->width() + SPRITE_ATLAS_PADDING > width) {
+			x = SPRITE_ATLAS_PADDING;
+			y += shelf_height + SPRITE_ATLAS_PADDING;
+			shelf_height = 0;
+		}
+		rects[id] = SkRect::MakeXYWH(x, y, image->width(), image->height());
+		x += image->width() + SPRITE_ATLAS_PADDING;
+		shelf_height = std::max(shelf_height, image->height());
+	}
+	int height = y + shelf_height + SPRITE_ATLAS_PADDING;
+
+	sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(width, height);
+	if(!surface) {
+		return false;
+	}
+	SkCanvas* canvas = surface->getCanvas();
+	canvas->clear(SK_ColorTRANSPARENT);
+	for(size_t id = 0; id < images.size(); id++) {
+		canvas->drawImage(images[id], rects[id].left(), rects[id].top());
+	}
+	atlas = surface->makeImageSnapshot();
+	return (bool)atlas;
+}
+
+void SpriteAtlas::clear() {
+	images.clear();
+	rects.clear();
+	atlas = nullptr;
+}
+
+void SpriteBatch::add(int id, float x, float y) {
+	xforms.push_back(SkRSXform::Make(1, 0, x, y));
+	rects.push_back(atlas.rect(id));
+}
+
+void SpriteBatch::add_rotated(int id, float radians, SkPoint center) {
+	const SkRect& rect = atlas.rect(id);
+	xforms.push_back(
+		SkRSXform::MakeFromRadians(1, radians, center.x(), center.y(), rect.width() / 2, rect.height() / 2));
+	rects.push_back(rect);
+}
+
+void SpriteBatch::draw(SkCanvas* canvas, const SkPaint* paint) {
+	if(xforms.empty()) {
+		return;
+	}
+	// Sprites aren't tinted, so the blend mode between colors and sprite is unused. The paint's blend mode is the one
+	// the batch is drawn with
+	canvas->drawAtlas(atlas.image(), xforms.data(), rects.data(), nullptr, xforms.size(), SkBlendMode::kSrcOver,
+		SkSamplingOptions(), nullptr, paint);
+	xforms.clear();
+	rects.clear();
+}
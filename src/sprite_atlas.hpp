@@ -0,0 +1,64 @@
+#pragma once
+
+#include <core/SkCanvas.h>
+#include <core/SkImage.h>
+#include <core/SkRSXform.h>
+#include <core/SkRect.h>
+#include <vector>
+
+// Small images packed into one raster image, so any mix of them can be drawn with a single drawAtlas call
+class SpriteAtlas {
+public:
+	// Adds image to the next build and returns its id, -1 for a null image
+	int add(const sk_sp<SkImage>& image);
+
+	// Packs every image added so far into shelves of one image. Ids stay valid until clear
+	bool build();
+
+	void clear();
+
+	// Where sprite id is in the atlas, the size of the image it was added from
+	const SkRect& rect(int id) const {
+		return rects[id];
+	}
+
+	const SkImage* image() const {
+		return atlas.get();
+	}
+
+	size_t num_sprites() const {
+		return rects.size();
+	}
+
+private:
+	// Kept so images added after a build are packed along with the earlier ones
+	std::vector<sk_sp<SkImage>> images;
+	std::vector<SkRect> rects;
+	sk_sp<SkImage> atlas;
+};
+
+// Sprites of one atlas that share a blend mode, each with its own transform, submitted as one drawAtlas call instead
+// of a draw per sprite
+class SpriteBatch {
+public:
+	SpriteBatch(const SpriteAtlas& atlas)
+		: atlas(atlas) { }
+
+	// Top left corner at x, y
+	void add(int id, float x, float y);
+
+	// Rotated by radians around its center, which is placed at center
+	void add_rotated(int id, float radians, SkPoint center);
+
+	// Draws every sprite added since the last draw in order, then empties the batch
+	void draw(SkCanvas* canvas, const SkPaint* paint = nullptr);
+
+	size_t size() const {
+		return xforms.size();
+	}
+
+private:
+	const SpriteAtlas& atlas;
+	std::vector<SkRSXform> xforms;
+	std::vector<SkRect> rects;
+};
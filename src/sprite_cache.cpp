@@ -0,0 +1,64 @@
+#include "sprite_cache.hpp"
+
+#include <codec/SkCodec.h>
+#include <core/SkBitmap.h>
+#include <core/SkCanvas.h>
+#include <core/SkStream.h>
+#include <core/SkSurface.h>
+#include <filesystem>
+#include <iostream>
+
+static const char* PLAYER_CHARACTOR_NAMES[NUM_PLAYER_CHARACTORS] = { "mario", "luigi", "toad", "toadette" };
+
+const PlayerSprite& PlayerSpriteCache::get(const std::string& gamestyle, uint8_t charactor, uint8_t state) {
+	static const PlayerSprite missing;
+	if(charactor >= NUM_PLAYER_CHARACTORS || state >= NUM_PLAYER_STATES) {
+		return missing;
+	}
+
+	Entry& entry = styles[gamestyle][charactor * NUM_PLAYER_STATES + state];
+	if(entry.tried) {
+		return entry.sprite;
+	}
+	entry.tried = true;
+
+	// Gamestyles also change images, the ones without their own fall back on the shared sprite
+	std::string character_dir = asset_dir + PLAYER_CHARACTOR_NAMES[charactor] + "/";
+	std::string filename      = character_dir + gamestyle + "/" + std::to_string(state) + ".png";
+	if(!std::filesystem::exists(filename)) {
+		filename = character_dir + std::to_string(state) + ".png";
+	}
+
+	std::unique_ptr<SkCodec> codec = SkCodec::MakeFromStream(SkStream::MakeFromFile(filename.c_str()));
+	if(!codec) {
+		std::cout << "Could not load player sprite " << filename << std::endl;
+		return entry.sprite;
+	}
+
+	SkBitmap bitmap;
+	SkImageInfo info = codec->getInfo().makeColorType(kBGRA_8888_SkColorType);
+	bitmap.allocPixels(info);
+	codec->getPixels(info, bitmap.getPixels(), bitmap.rowBytes());
+	bitmap.setImmutable();
+
+	int width  = bitmap.width() * scale;
+	int height = bitmap.height() * scale;
+	auto upscale = [&](bool mirrored) {
+		sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(width, height);
+		if(mirrored) {
+			// Scale for facing opposite direction
+			surface->getCanvas()->translate(width, 0);
+			surface->getCanvas()->scale(-1, 1);
+		}
+		surface->getCanvas()->drawImageRect(bitmap.asImage(), SkRect::MakeLTRB(0, 0, bitmap.width(), bitmap.height()),
+			SkRect::MakeWH(width, height), SkSamplingOptions(SkFilterMode::kNearest), nullptr,
+			SkCanvas::kStrict_SrcRectConstraint);
+		return surface->makeImageSnapshot();
+	};
+	entry.sprite.image    = upscale(false);
+	entry.sprite.mirrored = upscale(true);
+
+	loaded++;
+	bytes += (size_t)width * height * 4 * 2;
+	return entry.sprite;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <core/SkImage.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Mario, Luigi, Toad and Toadette
+constexpr int NUM_PLAYER_CHARACTORS = 4;
+
+// https://github.com/kinnay/Nintendo-File-Formats/wiki/SMM-2-Ninji-Ghosts#player-state
+// TODO some states have multiple possible states within them (eg walking)
+// 0 (standing, walking, running): column 3 row 2
+// 1 (jumping): column 7 row 2
+// 2 (swimming): column 10 row 2
+// 3 (climbing): column 14 row 2
+// 4 ("hipat" and link down slash): NONE
+// 5 (slipping): column 15 row 2
+// 6 ("wsld"): NONE
+// 7 (clear pipe and dry bones): column 17 row 2 second dry bones
+// 8 (cat attack and clown car): column 19 row 2 clown car in folder
+// 9 (tree top and lakitu cloud): column 19 row 2 cloud in other spritesheet
+// 10 (goomba shoe, koopa troopa, or yoshi): column 19 row 2 yoshi in other spritesheet
+// 11 (walking cat): column 3 row 2
+// 12 (unknown)
+constexpr int NUM_PLAYER_STATES = 16;
+
+struct PlayerSprite {
+	sk_sp<SkImage> image;
+	// Facing the other way
+	sk_sp<SkImage> mirrored;
+};
+
+// Upscaled player sprites keyed by game style, character and state, shared by every level of a run. A sprite is only
+// decoded the first time it's asked for, so levels of the same style share it and states nobody is seen in are never
+// loaded
+class PlayerSpriteCache {
+public:
+	// Sprites are read from asset_dir/<character>/<game style>/<state>.png, falling back on
+	// asset_dir/<character>/<state>.png, and scaled up scale times
+	PlayerSpriteCache(std::string asset_dir, int scale)
+		: asset_dir(std::move(asset_dir))
+		, scale(scale) { }
+
+	// Loads the sprite on first use. Both images are null when it can't be loaded
+	const PlayerSprite& get(const std::string& gamestyle, uint8_t charactor, uint8_t state);
+
+	size_t num_loaded() const {
+		return loaded;
+	}
+
+	// Pixels held by every sprite loaded so far
+	size_t size_bytes() const {
+		return bytes;
+	}
+
+private:
+	struct Entry {
+		bool tried = false;
+		PlayerSprite sprite;
+	};
+
+	std::string asset_dir;
+	int scale;
+	std::unordered_map<std::string, std::array<Entry, NUM_PLAYER_CHARACTORS * NUM_PLAYER_STATES>> styles;
+	size_t loaded = 0;
+	size_t bytes  = 0;
+};
@@ -0,0 +1,29 @@
+#include "string_arena.hpp"
+
+#include <cstring>
+
+std::string_view StringArena::add(std::string_view string) {
+	if(string.empty()) {
+		return std::string_view();
+	}
+
+	if(string.size() > left) {
+		// Strings longer than a block get a block of their own, the current block keeps its space
+		if(string.size() > block_size / 4) {
+			blocks.emplace_back(new char[string.size()]);
+			memcpy(blocks.back().get(), string.data(), string.size());
+			used += string.size();
+			return std::string_view(blocks.back().get(), string.size());
+		}
+		blocks.emplace_back(new char[block_size]);
+		next = blocks.back().get();
+		left = block_size;
+	}
+
+	memcpy(next, string.data(), string.size());
+	std::string_view copy(next, string.size());
+	next += string.size();
+	left -= string.size();
+	used += string.size();
+	return copy;
+}
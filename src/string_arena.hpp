@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for strings that live as long as the arena. Strings are copied back to back into blocks that never
+// move, so the views handed out stay valid and thousands of short strings cost one allocation
+class StringArena {
+public:
+	StringArena(size_t block_size = 65536)
+		: block_size(block_size) { }
+
+	StringArena(const StringArena&) = delete;
+	StringArena& operator=(const StringArena&) = delete;
+	StringArena(StringArena&&) = default;
+	StringArena& operator=(StringArena&&) = default;
+
+	std::string_view add(std::string_view string);
+
+	size_t num_blocks() const {
+		return blocks.size();
+	}
+
+	size_t size_bytes() const {
+		return used;
+	}
+
+private:
+	std::vector<std::unique_ptr<char[]>> blocks;
+	size_t block_size;
+	char* next  = nullptr;
+	size_t left = 0;
+	size_t used = 0;
+};
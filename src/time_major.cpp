@@ -0,0 +1,194 @@
+#include "time_major.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Layout: header, slice offsets, slice counts, then one block per slice. A block holds the ranks, x, y, state and
+// flags of its slice back to back and is padded to 8 bytes, so a frame's data is one contiguous read
+constexpr uint64_t TIME_MAJOR_MAGIC   = 0x314D544A4E494E; // "NINJTM1"
+constexpr uint32_t TIME_MAJOR_VERSION = 1;
+
+struct TimeMajorHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t num_ranks;
+	uint64_t num_slices;
+	uint64_t blocks_size;
+};
+
+static_assert(sizeof(TimeMajorHeader) % 8 == 0);
+
+static size_t get_time_major_block_size(uint32_t count) {
+	return (count * 10 + 7) & ~(size_t)7;
+}
+
+static size_t get_time_major_blocks_start(uint64_t num_slices) {
+	size_t counts_end = sizeof(TimeMajorHeader) + (num_slices + 1) * sizeof(uint64_t) + num_slices * sizeof(uint32_t);
+	return (counts_end + 7) & ~(size_t)7;
+}
+
+std::string get_time_major_path(const std::string& dir, int data_id) {
+	return dir + "/" + std::to_string(data_id) + ".time.bin";
+}
+
+bool TimeMajorFrames::build(const LevelFrames& frames, std::span<const uint32_t> rank_paths, const std::string& path) {
+	owned.clear();
+	file.close();
+	data    = {};
+	offsets = {};
+	counts  = {};
+
+	// A path of n frames is in slices [0, n), so the counts follow from how many paths end at each length
+	std::vector<uint32_t> lengths(rank_paths.size());
+	size_t num_slices = 0;
+	for(uint32_t rank = 0; rank < rank_paths.size(); rank++) {
+		lengths[rank] = frames.path(rank_paths[rank]).size();
+		num_slices    = std::max<size_t>(num_slices, lengths[rank]);
+	}
+
+	std::vector<uint32_t> slice_counts(num_slices, 0);
+	for(auto length : lengths) {
+		if(length != 0) {
+			slice_counts[length - 1]++;
+		}
+	}
+	for(size_t t = num_slices; t > 1; t--) {
+		slice_counts[t - 2] += slice_counts[t - 1];
+	}
+
+	std::vector<uint64_t> slice_offsets(num_slices + 1, 0);
+	for(size_t t = 0; t < num_slices; t++) {
+		slice_offsets[t + 1] = slice_offsets[t] + get_time_major_block_size(slice_counts[t]);
+	}
+
+	TimeMajorHeader header {};
+	header.magic       = TIME_MAJOR_MAGIC;
+	header.version     = TIME_MAJOR_VERSION;
+	header.num_ranks   = rank_paths.size();
+	header.num_slices  = num_slices;
+	header.blocks_size = slice_offsets[num_slices];
+
+	size_t blocks_start = get_time_major_blocks_start(num_slices);
+	std::vector<uint8_t> prologue(blocks_start, 0);
+	memcpy(prologue.data(), &header, sizeof(header));
+	memcpy(prologue.data() + sizeof(header), slice_offsets.data(), slice_offsets.size() * sizeof(uint64_t));
+	memcpy(prologue.data() + sizeof(header) + slice_offsets.size() * sizeof(uint64_t), slice_counts.data(),
+		slice_counts.size() * sizeof(uint32_t));
+
+	std::string temp_path = path + ".tmp";
+	std::ofstream table_file;
+	if(path.empty()) {
+		owned.resize(blocks_start + header.blocks_size);
+		memcpy(owned.data(), prologue.data(), prologue.size());
+	} else {
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+		table_file.open(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!table_file) {
+			return false;
+		}
+		table_file.write((const char*)prologue.data(), prologue.size());
+	}
+
+	// Ranks still running, in rank order. Dropping the ones that just finished keeps the transpose proportional to
+	// the number of frames rather than slices times ranks
+	std::vector<uint32_t> running(rank_paths.size());
+	for(uint32_t rank = 0; rank < rank_paths.size(); rank++) {
+		running[rank] = rank;
+	}
+	running.erase(std::remove_if(running.begin(), running.end(), [&](uint32_t rank) { return lengths[rank] == 0; }),
+		running.end());
+
+	auto all_offsets = frames.offsets();
+	auto all_x       = frames.x();
+	auto all_y       = frames.y();
+	auto all_state   = frames.state();
+	auto all_flags   = frames.flags();
+	std::vector<uint8_t> block;
+	for(size_t t = 0; t < num_slices; t++) {
+		uint32_t count = running.size();
+		block.assign(get_time_major_block_size(count), 0);
+		auto ranks = (uint32_t*)block.data();
+		auto x     = (uint16_t*)(block.data() + count * 4);
+		auto y     = (uint16_t*)(block.data() + count * 6);
+		auto state = block.data() + count * 8;
+		auto flags = block.data() + count * 9;
+
+		for(uint32_t i = 0; i < count; i++) {
+			uint32_t rank = running[i];
+			size_t frame  = all_offsets[rank_paths[rank]] + t;
+			ranks[i]      = rank;
+			x[i]          = all_x[frame];
+			y[i]          = all_y[frame];
+			state[i]      = all_state[frame];
+			flags[i]      = all_flags[frame];
+		}
+
+		if(path.empty()) {
+			memcpy(owned.data() + blocks_start + slice_offsets[t], block.data(), block.size());
+		} else {
+			table_file.write((const char*)block.data(), block.size());
+		}
+
+		running.erase(
+			std::remove_if(running.begin(), running.end(), [&](uint32_t rank) { return lengths[rank] == t + 1; }),
+			running.end());
+	}
+
+	if(path.empty()) {
+		data = owned;
+	} else {
+		table_file.close();
+		if(!table_file) {
+			std::filesystem::remove(temp_path);
+			return false;
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(temp_path, path, ec);
+		if(ec || !open(path)) {
+			return false;
+		}
+	}
+
+	auto offsets_start = data.data() + sizeof(TimeMajorHeader);
+	auto counts_start  = offsets_start + (num_slices + 1) * sizeof(uint64_t);
+	offsets            = std::span<const uint64_t>((const uint64_t*)offsets_start, num_slices + 1);
+	counts             = std::span<const uint32_t>((const uint32_t*)counts_start, num_slices);
+	return true;
+}
+
+bool TimeMajorFrames::open(const std::string& path) {
+	if(!file.open(path)) {
+		return false;
+	}
+
+	// The file was just written by build, so only its shape is checked
+	auto header = (const TimeMajorHeader*)file.data();
+	if(file.size() < sizeof(TimeMajorHeader) || header->magic != TIME_MAJOR_MAGIC
+		|| header->version != TIME_MAJOR_VERSION
+		|| file.size() != get_time_major_blocks_start(header->num_slices) + header->blocks_size) {
+		file.close();
+		return false;
+	}
+
+	data = std::span<const uint8_t>(file.data(), file.size());
+	return true;
+}
+
+TimeSlice TimeMajorFrames::slice(size_t t) const {
+	if(t >= counts.size()) {
+		return TimeSlice {};
+	}
+
+	uint32_t count = counts[t];
+	auto block     = data.data() + get_time_major_blocks_start(counts.size()) + offsets[t];
+	return TimeSlice {
+		std::span<const uint32_t>((const uint32_t*)block, count),
+		std::span<const uint16_t>((const uint16_t*)(block + count * 4), count),
+		std::span<const uint16_t>((const uint16_t*)(block + count * 6), count),
+		std::span<const uint8_t>(block + count * 8, count),
+		std::span<const uint8_t>(block + count * 9, count),
+	};
+}
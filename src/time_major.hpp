@@ -0,0 +1,75 @@
+#pragma once
+
+#include "frame_store.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Frame t of every path still running at t, ordered by rank. Finished paths are left out, so the slice shrinks as
+// ghosts finish
+struct TimeSlice {
+	std::span<const uint32_t> ranks;
+	std::span<const uint16_t> x;
+	std::span<const uint16_t> y;
+	std::span<const uint8_t> state;
+	std::span<const uint8_t> flags;
+
+	size_t size() const {
+		return ranks.size();
+	}
+
+	// Walks cursor forward past every rank below rank and reports whether rank is in the slice. Visiting ranks in
+	// increasing order makes a whole frame one pass over the slice
+	bool find(uint32_t rank, size_t& cursor, NinjiFrame& frame) const {
+		while(cursor < ranks.size() && ranks[cursor] < rank) {
+			cursor++;
+		}
+		if(cursor == ranks.size() || ranks[cursor] != rank) {
+			return false;
+		}
+		frame = NinjiFrame { state[cursor], x[cursor], y[cursor], flags[cursor] };
+		return true;
+	}
+};
+
+// A level's frames transposed to time major order, so drawing frame t reads one contiguous block instead of one
+// frame out of every path. Built once after ingest, either in memory or written to a file and mapped back for
+// levels too big to keep resident
+class TimeMajorFrames {
+public:
+	TimeMajorFrames() = default;
+	// Views point into the owned buffer or the mapping, both of which survive a move but not a copy
+	TimeMajorFrames(const TimeMajorFrames&) = delete;
+	TimeMajorFrames& operator=(const TimeMajorFrames&) = delete;
+	TimeMajorFrames(TimeMajorFrames&&) = default;
+	TimeMajorFrames& operator=(TimeMajorFrames&&) = default;
+
+	// rank_paths[rank] is the path drawn at that rank. With an empty file path the table is kept in memory
+	bool build(const LevelFrames& frames, std::span<const uint32_t> rank_paths, const std::string& path = "");
+
+	size_t num_slices() const {
+		return counts.size();
+	}
+
+	// Empty past the end of the longest path
+	TimeSlice slice(size_t t) const;
+
+	size_t size_bytes() const {
+		return data.size();
+	}
+
+private:
+	bool open(const std::string& path);
+
+	std::vector<uint8_t> owned;
+	MappedFile file;
+
+	std::span<const uint8_t> data;
+	std::span<const uint64_t> offsets;
+	std::span<const uint32_t> counts;
+};
+
+std::string get_time_major_path(const std::string& dir, int data_id);
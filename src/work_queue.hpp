@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Bounded multi producer, multi consumer queue. Pushing blocks while the queue is full so a fast producer can't run
+// ahead of the consumers
+template <typename T> class WorkQueue {
+public:
+	WorkQueue(size_t capacity)
+		: capacity(capacity) { }
+
+	bool push(T item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+		if(closed) {
+			return false;
+		}
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+		return true;
+	}
+
+	// Returns false once the queue is closed and drained
+	bool pop(T& item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		not_empty.wait(lock, [&] { return closed || !items.empty(); });
+		if(items.empty()) {
+			return false;
+		}
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+
+private:
+	size_t capacity;
+	bool closed = false;
+	std::deque<T> items;
+	std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+};